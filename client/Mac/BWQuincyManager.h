@@ -76,6 +76,8 @@
   NSTimeInterval _maxTimeIntervalOfCrashForReturnMainApplicationDelay;
   
   NSInteger         _statusCode;
+  NSTimeInterval    _retryAfter;
+  NSDate            *_nextSendDate;
   NSMutableURLRequest *_request;
   NSURLConnection   *_urlConnection;
   NSMutableData     *_responseData;
@@ -87,6 +89,7 @@
   NSString   *_companyName;
   BOOL       _autoSubmitCrashReport;
   BOOL       _askUserDetails;
+  BOOL       _compressPostBody;
   
   BOOL       _debugLogEnabled;
   
@@ -95,6 +98,7 @@
   NSString   *_userEmail;
   
   NSMutableArray *_crashFiles;
+  NSMutableDictionary *_crashUUIDs;
   NSString       *_crashesDir;
   NSString       *_settingsFile;
   NSString       *_analyzerInProgressFile;
@@ -169,6 +173,18 @@
 @property (nonatomic, retain) NSString *companyName;
 
 
+/**
+ *  Defines if crash reports should be sent gzip compressed
+ *
+ *  Crash reports compress very well, which makes sending them a lot faster on
+ *  slow connections. Only enable this if the QuincyKit server supports compressed
+ *  submissions. It has no effect when using HockeyApp.
+ *
+ *  Default: _NO_
+ */
+@property (nonatomic, assign, getter=shouldCompressPostBody) BOOL compressPostBody;
+
+
 /**
  *  Trap fatal signals via a Mach exception server.
  *
@@ -34,6 +34,7 @@
 #import "BWQuincyUI.h"
 #import <sys/sysctl.h>
 #import <CrashReporter/CrashReporter.h>
+#include <zlib.h>
 
 #define SDK_NAME @"Quincy"
 #define SDK_VERSION @"3.0"
@@ -49,6 +50,9 @@ NSString *const kQuincyAutomaticallySendCrashReports = @"QuincyAutomaticallySend
 // stores the set of crashreports that have been approved but aren't sent yet
 NSString *const kQuincyApprovedCrashReports = @"QuincyApprovedCrashReports";
 
+// stores the date before which the server asked not to send crash reports again
+NSString *const kQuincyNextSendDate = @"QuincyNextSendDate";
+
 // keys for meta information associated to each crash
 NSString *const kQuincyMetaUserEmail = @"QuincyMetaUserEmail";
 NSString *const kQuincyMetaUserID = @"QuincyMetaUserID";
@@ -81,6 +85,57 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
 };
 
 
+static NSData *BWQuincyGzipData(NSData *data) {
+  if ([data length] == 0) return nil;
+  
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  
+  // window bits 15 + 16 create a gzip header and trailer
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return nil;
+  
+  NSMutableData *compressed = [NSMutableData dataWithLength:deflateBound(&stream, (uLong)[data length])];
+  
+  stream.next_in = (Bytef *)[data bytes];
+  stream.avail_in = (uInt)[data length];
+  stream.next_out = [compressed mutableBytes];
+  stream.avail_out = (uInt)[compressed length];
+  
+  int result = deflate(&stream, Z_FINISH);
+  [compressed setLength:stream.total_out];
+  deflateEnd(&stream);
+  
+  if (result != Z_STREAM_END) return nil;
+  
+  return compressed;
+}
+
+/**
+ * Get the incident identifiers of the crashes acknowledged by the server
+ *
+ * @return The identifiers listed in a `<response>` of the server, or nil if the server
+ *         only answered with one result for all crashes
+ */
+static NSSet *BWQuincyAcknowledgedUUIDs(NSData *responseData) {
+  NSString *response = [[[NSString alloc] initWithData:responseData encoding:NSUTF8StringEncoding] autorelease];
+  if (!response || [response rangeOfString:@"<response>"].location == NSNotFound) return nil;
+  
+  NSMutableSet *uuids = [NSMutableSet set];
+  NSScanner *scanner = [NSScanner scannerWithString:response];
+  NSString *uuid = nil;
+  
+  while (![scanner isAtEnd]) {
+    [scanner scanUpToString:@"<crash uuid=\"" intoString:NULL];
+    if (![scanner scanString:@"<crash uuid=\"" intoString:NULL]) break;
+    if ([scanner scanUpToString:@"\"" intoString:&uuid])
+      [uuids addObject:[uuid uppercaseString]];
+  }
+  
+  return uuids;
+}
+
+
 @implementation BWQuincyManager
 
 @synthesize delegate = _delegate;
@@ -92,6 +147,7 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
 @synthesize userName = _userName;
 @synthesize userEmail = _userEmail;
 @synthesize askUserDetails = _askUserDetails;
+@synthesize compressPostBody = _compressPostBody;
 @synthesize timeintervalCrashInLastSessionOccured = _timeintervalCrashInLastSessionOccured;
 @synthesize maxTimeIntervalOfCrashForReturnMainApplicationDelay = _maxTimeIntervalOfCrashForReturnMainApplicationDelay;
 @synthesize enableMachExceptionHandler = _enableMachExceptionHandler;
@@ -122,6 +178,7 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
     
     _fileManager = [[NSFileManager alloc] init];
     _askUserDetails = YES;
+    _compressPostBody = NO;
     
     _userEmail = nil;
     _userName = nil;
@@ -137,6 +194,7 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
     _didCrashInLastSession = NO;
     
     _crashFiles = [[NSMutableArray alloc] init];
+    _crashUUIDs = [[NSMutableDictionary alloc] init];
     _crashesDir = nil;
     
     _invokedReturnToMainApplication = NO;
@@ -195,6 +253,8 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
   [_fileManager release]; _fileManager = nil;
   
   [_crashFiles release]; _crashFiles = nil;
+  [_crashUUIDs release]; _crashUUIDs = nil;
+  [_nextSendDate release]; _nextSendDate = nil;
   [_crashesDir release]; _crashesDir = nil;
   [_settingsFile release]; _settingsFile = nil;
   [_analyzerInProgressFile release]; _analyzerInProgressFile = nil;
@@ -226,6 +286,9 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
   if (self.userEmail)
     [rootObj setObject:self.userEmail forKey:kQuincyMetaUserEmail];
 
+  if (_nextSendDate)
+    [rootObj setObject:_nextSendDate forKey:kQuincyNextSendDate];
+
   NSData *plist = [NSPropertyListSerialization dataFromPropertyList:(id)rootObj
                                                              format:NSPropertyListBinaryFormat_v1_0
                                                    errorDescription:&errorString];
@@ -263,6 +326,11 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
 
     if ([rootObj objectForKey:kQuincyMetaUserEmail])
       _userEmail = [rootObj objectForKey:kQuincyMetaUserEmail];
+
+    if ([rootObj objectForKey:kQuincyNextSendDate]) {
+      [_nextSendDate release];
+      _nextSendDate = [[rootObj objectForKey:kQuincyNextSendDate] retain];
+    }
     
   } else {
     BWQuincyLog(@"ERROR: Reading crash manager settings.");
@@ -277,11 +345,39 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
     [_fileManager removeItemAtPath:[[_crashFiles objectAtIndex:i] stringByAppendingString:@".meta"] error:&error];
   }
   [_crashFiles removeAllObjects];
+  [_crashUUIDs removeAllObjects];
   [_approvedCrashReports removeAllObjects];
   
   [self saveSettings];
 }
 
+/**
+ * Remove the crash reports the server acknowledged
+ *
+ * All other crash reports stay approved and are sent again with the next submission.
+ * Crash reports without incident identifier can't be acknowledged, they are removed
+ * once the server answered at all.
+ */
+- (void)cleanAcknowledgedCrashReports:(NSSet *)uuids {
+  NSError *error = NULL;
+  
+  for (NSString *filename in [[_crashFiles copy] autorelease]) {
+    NSString *uuid = [_crashUUIDs objectForKey:filename];
+    if ([uuid length] > 0 && ![uuids containsObject:uuid]) continue;
+    
+    [_fileManager removeItemAtPath:filename error:&error];
+    [_fileManager removeItemAtPath:[filename stringByAppendingString:@".meta"] error:&error];
+    [_approvedCrashReports removeObjectForKey:filename];
+    [_crashFiles removeObject:filename];
+  }
+  [_crashUUIDs removeAllObjects];
+  
+  if ([_crashFiles count] > 0)
+    BWQuincyLog(@"INFO: %li crash reports were not acknowledged and will be sent again.", (unsigned long)[_crashFiles count]);
+  
+  [self saveSettings];
+}
+
 - (NSString *)extractAppUUIDs:(PLCrashReport *)report {
   NSMutableString *uuidString = [NSMutableString string];
   NSArray *uuidArray = [BWCrashReportTextFormatter arrayOfAppUUIDsForCrashReport:report];
@@ -846,6 +942,7 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
       
       // store this crash report as user approved, so if it fails it will retry automatically
       [_approvedCrashReports setObject:[NSNumber numberWithBool:YES] forKey:filename];
+      [_crashUUIDs setObject:crashUUID forKey:filename];
     } else {
       // we cannot do anything with this report, so delete it
       [_fileManager removeItemAtPath:filename error:&error];
@@ -857,7 +954,11 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
   // clear cache
   [_dictOfLastSessionCrash removeAllObjects];
   
-  if (crashes != nil) {
+  if (crashes != nil && _nextSendDate && [_nextSendDate timeIntervalSinceNow] > 0) {
+    // the server is busy, the approved crash reports are sent on a later launch
+    BWQuincyLog(@"INFO: Sending crash reports deferred until %@.", _nextSendDate);
+    [self returnToMainApplication];
+  } else if (crashes != nil) {
     [self postXML:[NSString stringWithFormat:@"<crashes>%@</crashes>", crashes]];
   } else {
     [self returnToMainApplication];
@@ -880,29 +981,45 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
                                        ]
                   ]] retain];
   } else {
-    _request = [[NSMutableURLRequest requestWithURL:[NSURL URLWithString:self.submissionURL]] retain];
+    // ask the QuincyKit server for the result of each crash
+    NSString *separator = ([self.submissionURL rangeOfString:@"?"].location == NSNotFound) ? @"?" : @"&";
+    _request = [[NSMutableURLRequest requestWithURL:[NSURL URLWithString:[NSString stringWithFormat:@"%@%@ack=1", self.submissionURL, separator]]] retain];
   }
   
   [_request setValue:@"Quincy/Mac" forHTTPHeaderField:@"User-Agent"];
   [_request setValue:@"gzip" forHTTPHeaderField:@"Accept-Encoding"];
   [_request setTimeoutInterval: 15];
   [_request setHTTPMethod:@"POST"];
-  NSString *contentType = [NSString stringWithFormat:@"multipart/form-data; boundary=%@", boundary];
-  [_request setValue:contentType forHTTPHeaderField:@"Content-type"];
   
-  NSMutableData *postBody =  [NSMutableData data];
-  [postBody appendData:[[NSString stringWithFormat:@"--%@\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
-  if (self.appIdentifier) {
-    [postBody appendData:[@"Content-Disposition: form-data; name=\"xml\"; filename=\"crash.xml\"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-    [postBody appendData:[[NSString stringWithFormat:@"Content-Type: text/xml\r\n\r\n"] dataUsingEncoding:NSUTF8StringEncoding]];
+  // the QuincyKit server also accepts the plain XML as a gzip compressed body
+  NSData *compressedBody = nil;
+  if (!self.appIdentifier && self.shouldCompressPostBody) {
+    compressedBody = BWQuincyGzipData([xml dataUsingEncoding:NSUTF8StringEncoding]);
+  }
+  
+  if (compressedBody) {
+    [_request setValue:@"text/xml" forHTTPHeaderField:@"Content-type"];
+    [_request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+    [_request setHTTPBody:compressedBody];
   } else {
-    [postBody appendData:[@"Content-Disposition: form-data; name=\"xmlstring\"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+    NSString *contentType = [NSString stringWithFormat:@"multipart/form-data; boundary=%@", boundary];
+    [_request setValue:contentType forHTTPHeaderField:@"Content-type"];
+  
+    NSMutableData *postBody =  [NSMutableData data];
+    [postBody appendData:[[NSString stringWithFormat:@"--%@\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
+    if (self.appIdentifier) {
+      [postBody appendData:[@"Content-Disposition: form-data; name=\"xml\"; filename=\"crash.xml\"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+      [postBody appendData:[[NSString stringWithFormat:@"Content-Type: text/xml\r\n\r\n"] dataUsingEncoding:NSUTF8StringEncoding]];
+    } else {
+      [postBody appendData:[@"Content-Disposition: form-data; name=\"xmlstring\"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    [postBody appendData:[xml dataUsingEncoding:NSUTF8StringEncoding]];
+    [postBody appendData:[[NSString stringWithFormat:@"\r\n--%@--\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
+    [_request setHTTPBody:postBody];
   }
-  [postBody appendData:[xml dataUsingEncoding:NSUTF8StringEncoding]];
-  [postBody appendData:[[NSString stringWithFormat:@"\r\n--%@--\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
-  [_request setHTTPBody:postBody];
   
   _statusCode = 200;
+  _retryAfter = 0;
   
   if (_timeintervalCrashInLastSessionOccured > -1 &&
       _timeintervalCrashInLastSessionOccured <= _maxTimeIntervalOfCrashForReturnMainApplicationDelay) {
@@ -919,6 +1036,7 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
     
     _responseData = [[NSMutableData alloc] initWithData:synchronousResponseData];
     _statusCode = [response statusCode];
+    _retryAfter = [[[response allHeaderFields] objectForKey:@"Retry-After"] doubleValue];
     
     [self processServerResult];
   } else {
@@ -945,8 +1063,20 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
 - (void)processServerResult {
   NSError *error = nil;
   
+  // the server asks not to send again for a while, e.g. because too many crashes of this app arrive
+  if (_retryAfter > 0) {
+    [_nextSendDate release];
+    _nextSendDate = [[NSDate dateWithTimeIntervalSinceNow:_retryAfter] retain];
+    [self saveSettings];
+  }
+  
   if (_statusCode >= 200 && _statusCode < 400 && _responseData != nil && [_responseData length] > 0) {
-    [self cleanCrashReports];
+    NSSet *acknowledgedUUIDs = self.appIdentifier ? nil : BWQuincyAcknowledgedUUIDs(_responseData);
+    if (acknowledgedUUIDs) {
+      [self cleanAcknowledgedCrashReports:acknowledgedUUIDs];
+    } else {
+      [self cleanCrashReports];
+    }
     
     // HockeyApp uses PList XML format
     NSMutableDictionary *response = [NSPropertyListSerialization propertyListFromData:_responseData
@@ -1019,6 +1149,7 @@ typedef NS_ENUM (NSInteger, BWQuincyErrorReason) {
 - (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response {
   if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
     _statusCode = [(NSHTTPURLResponse *)response statusCode];
+    _retryAfter = [[[(NSHTTPURLResponse *)response allHeaderFields] objectForKey:@"Retry-After"] doubleValue];
   }
 }
 
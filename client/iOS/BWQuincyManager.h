@@ -133,6 +133,20 @@
 @property (nonatomic, assign, getter=shouldAutoSubmitCrashReport) BOOL autoSubmitCrashReport;
 
 
+/**
+ Defines if crash reports should be sent gzip compressed
+ 
+ Crash reports compress very well, which makes sending them a lot faster on
+ slow connections. Only enable this if the QuincyKit server supports compressed
+ submissions. It has no effect when using HockeyApp.
+ 
+ Default: _NO_
+ 
+ @see submissionURL
+ */
+@property (nonatomic, assign, getter=shouldCompressPostBody) BOOL compressPostBody;
+
+
 /**
  *  Trap fatal signals via a Mach exception server.
  *
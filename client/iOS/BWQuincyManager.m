@@ -38,6 +38,7 @@
 
 #include <sys/sysctl.h>
 #include <inttypes.h> //needed for PRIx64 macro
+#include <zlib.h>
 
 #define SDK_NAME @"Quincy"
 #define SDK_VERSION @"3.0.0"
@@ -48,6 +49,7 @@
 
 NSBundle *quincyBundle(void);
 NSString *BWQuincyLocalize(NSString *stringToken);
+NSData *BWQuincyGzipData(NSData *data);
 
 NSString *const kBWQuincyErrorDomain = @"BWQuincyErrorDomain";
 
@@ -86,6 +88,9 @@ NSString *const kQuincyKitAppInstallationUUID = @"QuincyKitAppInstallationUUID";
 // stores the set of crashreports that have been approved but aren't sent yet
 NSString *const kQuincyApprovedCrashReports = @"QuincyApprovedCrashReports";
 
+// stores the date before which the server asked not to send crash reports again
+NSString *const kQuincyNextSendDate = @"QuincyNextSendDate";
+
 // keys for meta information associated to each crash
 NSString *const kQuincyMetaUserEmail = @"QuincyMetaUserEmail";
 NSString *const kQuincyMetaUserID = @"QuincyMetaUserID";
@@ -120,10 +125,61 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
 }
 
 
+NSData *BWQuincyGzipData(NSData *data) {
+  if ([data length] == 0) return nil;
+  
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  
+  // window bits 15 + 16 create a gzip header and trailer
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return nil;
+  
+  NSMutableData *compressed = [NSMutableData dataWithLength:deflateBound(&stream, (uLong)[data length])];
+  
+  stream.next_in = (Bytef *)[data bytes];
+  stream.avail_in = (uInt)[data length];
+  stream.next_out = [compressed mutableBytes];
+  stream.avail_out = (uInt)[compressed length];
+  
+  int result = deflate(&stream, Z_FINISH);
+  [compressed setLength:stream.total_out];
+  deflateEnd(&stream);
+  
+  if (result != Z_STREAM_END) return nil;
+  
+  return compressed;
+}
+
+/**
+ * Get the incident identifiers of the crashes acknowledged by the server
+ *
+ * @return The identifiers listed in a `<response>` of the server, or nil if the server
+ *         only answered with one result for all crashes
+ */
+static NSSet *BWQuincyAcknowledgedUUIDs(NSData *responseData) {
+  NSString *response = [[NSString alloc] initWithData:responseData encoding:NSUTF8StringEncoding];
+  if (!response || [response rangeOfString:@"<response>"].location == NSNotFound) return nil;
+  
+  NSMutableSet *uuids = [NSMutableSet set];
+  NSScanner *scanner = [NSScanner scannerWithString:response];
+  NSString *uuid = nil;
+  
+  while (![scanner isAtEnd]) {
+    [scanner scanUpToString:@"<crash uuid=\"" intoString:NULL];
+    if (![scanner scanString:@"<crash uuid=\"" intoString:NULL]) break;
+    if ([scanner scanUpToString:@"\"" intoString:&uuid])
+      [uuids addObject:[uuid uppercaseString]];
+  }
+  
+  return uuids;
+}
+
 @implementation BWQuincyManager {
   NSMutableDictionary *_approvedCrashReports;
   
   NSMutableArray *_crashFiles;
+  NSMutableDictionary *_crashUUIDs;
   NSString       *_crashesDir;
   NSString       *_settingsFile;
   NSString       *_analyzerInProgressFile;
@@ -138,6 +194,8 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
   
   NSMutableData *_responseData;
   NSInteger _statusCode;
+  NSTimeInterval _retryAfter;
+  NSDate *_nextSendDate;
   
   NSMutableURLRequest *_request;
   NSURLConnection *_urlConnection;
@@ -186,6 +244,7 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
     
     _fileManager = [[NSFileManager alloc] init];
     _crashFiles = [[NSMutableArray alloc] init];
+    _crashUUIDs = [[NSMutableDictionary alloc] init];
     
     _appStoreEnvironment = NO;
 #if !TARGET_IPHONE_SIMULATOR
@@ -259,6 +318,9 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
   
   if (self.userEmail)
     [rootObj setObject:self.userEmail forKey:kQuincyMetaUserEmail];
+  
+  if (_nextSendDate)
+    [rootObj setObject:_nextSendDate forKey:kQuincyNextSendDate];
 
   NSData *plist = [NSPropertyListSerialization dataFromPropertyList:(id)rootObj
                                                              format:NSPropertyListBinaryFormat_v1_0
@@ -302,11 +364,43 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
     if ([rootObj objectForKey:kQuincyMetaUserEmail])
       _userEmail = [rootObj objectForKey:kQuincyMetaUserEmail];
 
+    if ([rootObj objectForKey:kQuincyNextSendDate])
+      _nextSendDate = [rootObj objectForKey:kQuincyNextSendDate];
+
   } else {
     BWQuincyLog(@"ERROR: Reading crash manager settings.");
   }
 }
 
+/**
+ * Remove the crash reports the server acknowledged
+ *
+ * All other crash reports stay approved and are sent again with the next submission.
+ * Crash reports without incident identifier can't be acknowledged, they are removed
+ * once the server answered at all.
+ *
+ * @param uuids The incident identifiers of the acknowledged crashes
+ */
+- (void)cleanAcknowledgedCrashReports:(NSSet *)uuids {
+  NSError *error = NULL;
+  
+  for (NSString *filename in [_crashFiles copy]) {
+    NSString *uuid = [_crashUUIDs objectForKey:filename];
+    if ([uuid length] > 0 && ![uuids containsObject:uuid]) continue;
+    
+    [_fileManager removeItemAtPath:filename error:&error];
+    [_fileManager removeItemAtPath:[filename stringByAppendingString:@".meta"] error:&error];
+    [_crashFiles removeObject:filename];
+    [_approvedCrashReports removeObjectForKey:filename];
+  }
+  [_crashUUIDs removeAllObjects];
+  
+  if ([_crashFiles count] > 0)
+    BWQuincyLog(@"INFO: %lu crash reports were not acknowledged and will be sent again.", (unsigned long)[_crashFiles count]);
+  
+  [self saveSettings];
+}
+
 /**
  *	 Remove all crash reports and stored meta data for each from the file system and keychain
  */
@@ -319,6 +413,8 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
   }
   [_crashFiles removeAllObjects];
 
+  [_crashUUIDs removeAllObjects];
+
   [[NSUserDefaults standardUserDefaults] setObject:nil forKey:kQuincyApprovedCrashReports];
 }
 
@@ -917,6 +1013,7 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
       
       // store this crash report as user approved, so if it fails it will retry automatically
       [_approvedCrashReports setObject:[NSNumber numberWithBool:YES] forKey:filename];
+      [_crashUUIDs setObject:crashUUID forKey:filename];
     } else {
       // we cannot do anything with this report, so delete it
       [_fileManager removeItemAtPath:filename error:&error];
@@ -927,8 +1024,14 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
   [self saveSettings];
   
   if (crashes != nil) {
-    BWQuincyLog(@"INFO: Sending crash reports:\n%@", crashes);
-    [self postXML:[NSString stringWithFormat:@"<crashes>%@</crashes>", crashes]];
+    if (_nextSendDate && [_nextSendDate timeIntervalSinceNow] > 0) {
+      // the server is busy, the approved crash reports are sent on a later launch
+      BWQuincyLog(@"INFO: Sending crash reports deferred until %@.", _nextSendDate);
+      _sendingInProgress = NO;
+    } else {
+      BWQuincyLog(@"INFO: Sending crash reports:\n%@", crashes);
+      [self postXML:[NSString stringWithFormat:@"<crashes>%@</crashes>", crashes]];
+    }
   }
 }
 
@@ -988,7 +1091,9 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
                                       ]
                  ]];
   } else {
-    _request = [NSMutableURLRequest requestWithURL:[NSURL URLWithString:self.submissionURL]];
+    // ask the QuincyKit server for the result of each crash
+    NSString *separator = ([self.submissionURL rangeOfString:@"?"].location == NSNotFound) ? @"?" : @"&";
+    _request = [NSMutableURLRequest requestWithURL:[NSURL URLWithString:[NSString stringWithFormat:@"%@%@ack=1", self.submissionURL, separator]]];
   }
   
   [_request setCachePolicy: NSURLRequestReloadIgnoringLocalCacheData];
@@ -996,23 +1101,37 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
   [_request setValue:@"gzip" forHTTPHeaderField:@"Accept-Encoding"];
   [_request setTimeoutInterval: 15];
   [_request setHTTPMethod:@"POST"];
-  NSString *contentType = [NSString stringWithFormat:@"multipart/form-data; boundary=%@", boundary];
-  [_request setValue:contentType forHTTPHeaderField:@"Content-type"];
-	
-  NSMutableData *postBody =  [NSMutableData data];
-  [postBody appendData:[[NSString stringWithFormat:@"--%@\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
-  if (self.appIdentifier) {
-    [postBody appendData:[@"Content-Disposition: form-data; name=\"xml\"; filename=\"crash.xml\"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-    [postBody appendData:[[NSString stringWithFormat:@"Content-Type: text/xml\r\n\r\n"] dataUsingEncoding:NSUTF8StringEncoding]];
-  } else {
-    [postBody appendData:[@"Content-Disposition: form-data; name=\"xmlstring\"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+  
+  // the QuincyKit server also accepts the plain XML as a gzip compressed body
+  NSData *compressedBody = nil;
+  if (!self.appIdentifier && self.shouldCompressPostBody) {
+    compressedBody = BWQuincyGzipData([xml dataUsingEncoding:NSUTF8StringEncoding]);
   }
-  [postBody appendData:[xml dataUsingEncoding:NSUTF8StringEncoding]];
-  [postBody appendData:[[NSString stringWithFormat:@"\r\n--%@--\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
   
-  [_request setHTTPBody:postBody];
+  if (compressedBody) {
+    [_request setValue:@"text/xml" forHTTPHeaderField:@"Content-type"];
+    [_request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+    [_request setHTTPBody:compressedBody];
+  } else {
+    NSString *contentType = [NSString stringWithFormat:@"multipart/form-data; boundary=%@", boundary];
+    [_request setValue:contentType forHTTPHeaderField:@"Content-type"];
+	
+    NSMutableData *postBody =  [NSMutableData data];
+    [postBody appendData:[[NSString stringWithFormat:@"--%@\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
+    if (self.appIdentifier) {
+      [postBody appendData:[@"Content-Disposition: form-data; name=\"xml\"; filename=\"crash.xml\"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+      [postBody appendData:[[NSString stringWithFormat:@"Content-Type: text/xml\r\n\r\n"] dataUsingEncoding:NSUTF8StringEncoding]];
+    } else {
+      [postBody appendData:[@"Content-Disposition: form-data; name=\"xmlstring\"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    [postBody appendData:[xml dataUsingEncoding:NSUTF8StringEncoding]];
+    [postBody appendData:[[NSString stringWithFormat:@"\r\n--%@--\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
+  
+    [_request setHTTPBody:postBody];
+  }
 	
   _statusCode = 200;
+  _retryAfter = 0;
 	
   //Release when done in the delegate method
   _responseData = [[NSMutableData alloc] init];
@@ -1056,6 +1175,7 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
 - (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response {
   if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
     _statusCode = [(NSHTTPURLResponse *)response statusCode];
+    _retryAfter = [[[(NSHTTPURLResponse *)response allHeaderFields] objectForKey:@"Retry-After"] doubleValue];
   }
 }
 
@@ -1079,8 +1199,19 @@ NSString *BWQuincyLocalize(NSString *stringToken) {
 - (void)connectionDidFinishLoading:(NSURLConnection *)connection {
   NSError *error = nil;
   
+  // the server asks not to send again for a while, e.g. because too many crashes of this app arrive
+  if (_retryAfter > 0) {
+    _nextSendDate = [NSDate dateWithTimeIntervalSinceNow:_retryAfter];
+    [self saveSettings];
+  }
+  
   if (_statusCode >= 200 && _statusCode < 400 && _responseData != nil && [_responseData length] > 0) {
-    [self cleanCrashReports];
+    NSSet *acknowledgedUUIDs = self.appIdentifier ? nil : BWQuincyAcknowledgedUUIDs(_responseData);
+    if (acknowledgedUUIDs) {
+      [self cleanAcknowledgedCrashReports:acknowledgedUUIDs];
+    } else {
+      [self cleanCrashReports];
+    }
     
     if (self.appIdentifier) {
       // HockeyApp uses PList XML format
@@ -30,6 +30,7 @@
 
 require_once('../config.php');
 require_once('common.inc');
+require_once('retention.inc');
 
 init_database();
 parse_parameters(',action,id,groupid,bundleidentifier,version,fixversion,description,');
@@ -46,89 +47,91 @@ if (!isset($description)) $description = "";
 if ($action == "") die('Wrong parameters');
 
 if ($action == "deletecrashid" && $id != "") {
-    $query = "DELETE FROM ".$dbsymbolicatetable." WHERE crashid = ".$id;
-    $result = mysql_query($query) or die('Error in SQL '.$query);
-
-    $query = "DELETE from " . $dbcrashtable . " WHERE id=" . $id;
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    deleteCrashes(array(intval($id))) == "" or die('Error deleting crash '.$id);
         
     if ($groupid != "" && $groupid > -1) {
         // adjust amount and timestamp
         $query = "SELECT amount, latesttimestamp FROM ".$dbgrouptable." WHERE id = ".$groupid;
-        $result = mysql_query($query) or die('Error in SQL: '.$query);
+        $result = db_query($query) or die('Error in SQL: '.$query);
         
-        $numrows = mysql_num_rows($result);
+        $numrows = db_num_rows($result);
         if ($numrows > 0) {
             // get the status
-            while ($row = mysql_fetch_row($result)) {
+            while ($row = db_fetch_row($result)) {
                 $amount = $row[0];
                 $latest = $row[1];
                 $lastupdate = 0;
                 
                 if ($amount > 0) {
                     $query2 = "SELECT max(UNIX_TIMESTAMP(timestamp)) FROM ".$dbcrashtable." WHERE groupid = '".$groupid."'";
-                    $result2 = mysql_query($query2) or die('Error in SQL '.$query2);
-                    $numrows2 = mysql_num_rows($result2);
+                    $result2 = db_query($query2) or die('Error in SQL '.$query2);
+                    $numrows2 = db_num_rows($result2);
                     if ($numrows2 > 0) {
-                        $row2 = mysql_fetch_row($result2);
+                        $row2 = db_fetch_row($result2);
                         $lastupdate = $row2[0];
                         if ($lastupdate == "") $lastupdate = 0;
                     }
-                    mysql_free_result($result2);
+                    db_free_result($result2);
                     
                     $query2 = "UPDATE ".$dbgrouptable." SET latesttimestamp = ".$lastupdate." WHERE id = ".$groupid;
-                    $result2 = mysql_query($query2) or die('Error in SQL '.$query2);
+                    $result2 = db_query($query2) or die('Error in SQL '.$query2);
                 }
             }
         }
-        mysql_free_result($result);
+        db_free_result($result);
         
         $query = "UPDATE ".$dbgrouptable." SET amount=amount-1 WHERE id=".$groupid;
-        $result = mysql_query($query) or die('Error in SQL '.$query);
+        $result = db_query($query) or die('Error in SQL '.$query);
+        
+        $query = "UPDATE ".$dbissuetable." JOIN ".$dbgrouptable." ON ".$dbissuetable.".id = ".$dbgrouptable.".issueid SET ".$dbissuetable.".amount=".$dbissuetable.".amount-1 WHERE ".$dbgrouptable.".id=".$groupid;
+        $result = db_query($query) or die('Error in SQL '.$query);
     }
 } else if ($action == "deletegroupid" && $id != "") {
-    $query = "DELETE FROM ".$dbsymbolicatetable." WHERE crashid in (select id from ".$dbcrashtable." where groupid = ".$id.")";
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    // in chunks, so crashes can still be stored while a large group is deleted
+    do {
+        $crashids = deleteCrashChunk("groupid = ".intval($id));
+        is_array($crashids) or die('Error deleting the crashes of group '.$id);
+    } while (count($crashids) > 0);
+
+    // a crash stored since then keeps the group, deleting it would delete the crash too
+    $groups = $dbgrouptable.".id = ".intval($id)." AND NOT EXISTS (SELECT 1 FROM ".$dbcrashtable." WHERE ".$dbcrashtable.".groupid = ".$dbgrouptable.".id)";
     
-    $query = "DELETE FROM ".$dbcrashtable." WHERE groupid = ".$id;
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    db_query("START TRANSACTION") or die('Error in SQL START TRANSACTION');
     
-    $query = "DELETE FROM ".$dbgrouptable." WHERE id = ".$id;
-    $result = mysql_query($query) or die('Error in SQL '.$query);
-} else if ($action == "deletegroups" && $bundleidentifier != "" && $version != "") {
-    $query = "DELETE FROM ".$dbsymbolicatetable." WHERE crashid in (select id from ".$dbcrashtable." where bundleidentifier = '".$bundleidentifier."' and version = '".$version."')";
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    unlinkCrashGroupIssues($groups) or die('Error in SQL '.$dbissuetable);
     
-    $query = "DELETE FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundleidentifier."' and version = '".$version."'";
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    $query = "DELETE FROM ".$dbgrouptable." WHERE ".$groups;
+    $result = db_query($query) or die('Error in SQL '.$query);
     
-    $query = "DELETE FROM ".$dbgrouptable." WHERE bundleidentifier = '".$bundleidentifier."' and affected = '".$version."'";
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    db_query("COMMIT") or die('Error in SQL COMMIT');
+} else if ($action == "deletegroups" && $bundleidentifier != "" && $version != "") {
+    // cli/expire_crashes.php deletes the crashes and then the groups
+    deleteVersionQueue($bundleidentifier, $version) == "" or die('Error deleting version '.$version);
 } else if ($action == "updategroupid" && $id != "") {
-  $query = "UPDATE ".$dbgrouptable." SET description = '".mysql_real_escape_string($description)."' WHERE id = ".$id;
-  $result = mysql_query($query) or die('Error in SQL '.$query);
+  $query = "UPDATE ".$dbgrouptable." SET description = '".db_escape($description)."' WHERE id = ".$id;
+  $result = db_query($query) or die('Error in SQL '.$query);
 } else if ($action == "symbolicatecrashid" && $id != "") {
     $query = "SELECT id FROM ".$dbsymbolicatetable." WHERE crashid = ".$id;
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    $result = db_query($query) or die('Error in SQL '.$query);
     
-    $numrows = mysql_num_rows($result);
-    mysql_free_result($result);
+    $numrows = db_num_rows($result);
+    db_free_result($result);
     
     if ($numrows > 0)
         $query = "UPDATE ".$dbsymbolicatetable." SET done = 0 WHERE crashid = ".$id;
     else
         $query = "INSERT INTO ".$dbsymbolicatetable." (crashid, done) values (".$id.", 0)";
     
-    $result = mysql_query($query) or die('Error in SQL '.$query);	
+    $result = db_query($query) or die('Error in SQL '.$query);	
 } else if ($action == "getsymbolicationtodo") {
     $crashids = "";
     
     $query = "SELECT crashid FROM ".$dbsymbolicatetable." WHERE done = 0";
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    $result = db_query($query) or die('Error in SQL '.$query);
     
-    $numrows = mysql_num_rows($result);
+    $numrows = db_num_rows($result);
     if ($numrows > 0) {
-        while ($row = mysql_fetch_row($result))
+        while ($row = db_fetch_row($result))
         {
             if ($crashids != '')
                 $crashids .= ',';
@@ -136,49 +139,52 @@ if ($action == "deletecrashid" && $id != "") {
             $crashids .= $row[0];
     
         }
-        mysql_free_result($result);
+        db_free_result($result);
     }
     
     echo $crashids;
 } else if ($action == "getlogcrashid" && $id != "") {
-    $query = "SELECT log FROM ".$dbcrashtable." WHERE id = ".$id;
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    $query = "SELECT log, logcodec FROM ".$dbbodytable." WHERE crashid = ".$id;
+    $result = db_query($query) or die('Error in SQL '.$query);
     
-    $numrows = mysql_num_rows($result);
+    $numrows = db_num_rows($result);
     if ($numrows > 0) {
-        while ($row = mysql_fetch_row($result))
+        while ($row = db_fetch_row($result))
         {
-            echo $row[0];
+            $log = crashLogDecode($row[0], $row[1]);
+            if ($log === false) die('Crash log can not be decompressed');
+            echo $log;
         }
-        mysql_free_result($result);
+        db_free_result($result);
     }
 } else if ($action == "getdescriptioncrashid" && $id != "") {
-    $query = "SELECT description FROM ".$dbcrashtable." WHERE id = ".$id;
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    $query = "SELECT description FROM ".$dbbodytable." WHERE crashid = ".$id;
+    $result = db_query($query) or die('Error in SQL '.$query);
     
-    $numrows = mysql_num_rows($result);
+    $numrows = db_num_rows($result);
     if ($numrows > 0) {
-        while ($row = mysql_fetch_row($result))
+        while ($row = db_fetch_row($result))
         {
             echo $row[0];
         }
-        mysql_free_result($result);
+        db_free_result($result);
     }
 } else if ($action == "downloadcrashid" && ($id != "" || $groupid != "")) {
     $query = "";
     if ($groupid != "") {
-        $query = "SELECT log, timestamp FROM ".$dbcrashtable." WHERE groupid = '".$groupid."' ORDER BY systemversion desc, timestamp desc LIMIT 1";
+        $query = "SELECT log, timestamp, logcodec FROM ".$dbcrashtable." JOIN ".$dbbodytable." ON ".$dbbodytable.".crashid = ".$dbcrashtable.".id WHERE ".$dbcrashtable.".groupid = '".$groupid."' ORDER BY systemversion desc, timestamp desc LIMIT 1";
     } else {
-        $query = "SELECT log, timestamp FROM ".$dbcrashtable." WHERE id = '".$id."' ORDER BY systemversion desc, timestamp desc LIMIT 1";
+        $query = "SELECT log, timestamp, logcodec FROM ".$dbcrashtable." JOIN ".$dbbodytable." ON ".$dbbodytable.".crashid = ".$dbcrashtable.".id WHERE ".$dbcrashtable.".id = '".$id."'";
     }
-    $result = mysql_query($query) or die('Error in SQL '.$query);
+    $result = db_query($query) or die('Error in SQL '.$query);
     
-    $numrows = mysql_num_rows($result);
+    $numrows = db_num_rows($result);
     if ($numrows > 0) {
         // get the status
-        $row = mysql_fetch_row($result);
-        $log = $row[0];
+        $row = db_fetch_row($result);
+        $log = crashLogDecode($row[0], $row[2]);
         $timestamp = $row[1];
+        if ($log === false) die('Crash log can not be decompressed');
         
         // We'll be outputting a text file
         header('Content-type: application/text');
@@ -187,14 +193,14 @@ if ($action == "deletecrashid" && $id != "") {
         header('Content-Disposition: attachment; filename="'.$timestamp.'.crash"');
         echo $log;
         
-        mysql_free_result($result);
+        db_free_result($result);
     }
 } else {
     die('Wrong parameters');
 }
 
 
-mysql_close($link);
+db_close();
 
 
 ?>
\ No newline at end of file
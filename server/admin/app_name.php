@@ -45,7 +45,7 @@ if ($acceptallapps)
 }
 
 init_database();
-parse_parameters(',bundleidentifier,symbolicate,id,name,issuetrackerurl,hockeyappidentifier,pushids,emails,');
+parse_parameters(',bundleidentifier,symbolicate,id,name,issuetrackerurl,hockeyappidentifier,pushids,emails,retention,');
 
 if (!isset($bundleidentifier)) $bundleidentifier = "";
 if (!isset($symbolicate)) $symbolicate = "";
@@ -55,23 +55,30 @@ if (!isset($issuetrackerurl)) $issuetrackerurl = "";
 if (!isset($hockeyappidentifier)) $hockeyappidentifier = "";
 if (!isset($pushids)) $pushids = "";
 if (!isset($emails)) $emails = "";
+if (!isset($retention) || $retention === "") $retention = -1;
+
+// months the crashes are kept, -1 uses $crash_retention of config.php
+$retentions = array(-1 => 'Default retention', 0 => 'Keep forever', 1 => '1 month', 3 => '3 months', 6 => '6 months', 12 => '12 months', 24 => '24 months');
+$retentionvalue = (intval($retention) < 0) ? "NULL" : intval($retention);
 
 $query = "";
 // update the app
 if ($id != "" && $symbolicate != "") {
-	$query = "UPDATE ".$dbapptable." SET symbolicate = ".$symbolicate.", name = '".$name."', issuetrackerurl = '".$issuetrackerurl."', hockeyappidentifier = '".$hockeyappidentifier."', notifyemail = '".$emails."', notifypush = '".$pushids."' WHERE id = ".$id;
+	$query = "UPDATE ".$dbapptable." SET symbolicate = ".$symbolicate.", name = '".$name."', issuetrackerurl = '".$issuetrackerurl."', hockeyappidentifier = '".$hockeyappidentifier."', notifyemail = '".$emails."', notifypush = '".$pushids."', retention = ".$retentionvalue." WHERE id = ".$id;
 } else if ($bundleidentifier != "" && $id == "" && $symbolicate != "") {
 	// insert new app
 	// version is not available, so add it with status VERSION_STATUS_AVAILABLE
-	$query = "INSERT INTO ".$dbapptable." (bundleidentifier, name, symbolicate, issuetrackerurl, notifyemail, notifypush, hockeyappidentifier) values ('".$bundleidentifier."', '".$name."', ".$symbolicate.", '".$issuetrackerurl."', '".$emails."', '".$pushids."', '".$hockeyappidentifier."')";
+	$query = "INSERT INTO ".$dbapptable." (bundleidentifier, name, symbolicate, issuetrackerurl, notifyemail, notifypush, hockeyappidentifier, retention) values ('".$bundleidentifier."', '".$name."', ".$symbolicate.", '".$issuetrackerurl."', '".$emails."', '".$pushids."', '".$hockeyappidentifier."', ".$retentionvalue.")";
 } else if ($symbolicate != "" && $id != "") {
 	$query = "UPDATE ".$dbapptable." SET symbolicate = ".$symbolicate." WHERE id = ".$id;
 } else if ($id != "" && $symbolicate == "") {
 	// delete a version
 	$query = "DELETE FROM ".$dbapptable." WHERE id = ".$id;
 }
-if ($query != "")
-	$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+if ($query != "") {
+	$result = db_query($query) or die(end_with_result('Error in SQL '.$query));
+	invalidateMetadataCache('apps');
+}
 
 show_header('- Apps');
 
@@ -104,19 +111,22 @@ if (!$acceptallapps)
 	echo "<td><input type='text' name='issuetrackerurl' size='25' maxlength='4000' placeholder='%subject% %description%'/><br/>";
     echo "<input type='text' name='hockeyappidentifier' size='25' maxlength='4000' placeholder='HockeyApp Public Identifier'/>";
 	echo "</td><td><select name='symbolicate'><option value=0 selected>Don't symbolicate</option><option value=1>Symbolicate</option></select>";
-	echo "<br/></td>";
+	echo "<br/><select name='retention'>";
+	foreach ($retentions as $months => $title)
+		add_option($title, $months, -1);
+	echo "</select></td>";
 	echo "<td><button type='submit' class='button'>Create new App</button></td></tr>";	
 	echo '</table></form>';
 }
 
 // get all applications and their symbolication status
-$query = "SELECT bundleidentifier, symbolicate, id, name, issuetrackerurl, notifyemail, notifypush, hockeyappidentifier FROM ".$dbapptable." ORDER BY bundleidentifier asc, symbolicate desc";
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+$query = "SELECT bundleidentifier, symbolicate, id, name, issuetrackerurl, notifyemail, notifypush, hockeyappidentifier, retention FROM ".$dbapptable." ORDER BY bundleidentifier asc, symbolicate desc";
+$result = db_query($query) or die(end_with_result('Error in SQL '.$query));
 
-$numrows = mysql_num_rows($result);
+$numrows = db_num_rows($result);
 if ($numrows > 0) {
 	// get the status
-	while ($row = mysql_fetch_row($result))
+	while ($row = db_fetch_row($result))
 	{
 		$bundleidentifier = $row[0];
 		$symbolicate = $row[1];
@@ -126,6 +136,7 @@ if ($numrows > 0) {
 		$email = $row[5];
 		$push = $row[6];
 		$hockeyappidentifier = $row[7];
+		$retention = ($row[8] === null) ? -1 : $row[8];
 		
 		echo "<form name='update".$id."' action='app_name.php' method='get'><input type='hidden' name='id' value='".$id."'/>";
 		echo '<table>'.$cols;
@@ -151,19 +162,15 @@ if ($numrows > 0) {
         add_option("Don't symbolicate", 0, $symbolicate);
         add_option('Symbolicate', 1, $symbolicate);			
 		echo "</select><br/>";
+
+		echo "<select name='retention' onchange='javascript:document.update".$id.".submit();'>";
+		foreach ($retentions as $months => $title)
+			add_option($title, $months, $retention);
+		echo "</select><br/>";
 		
 		// get the total number of crashes
-        $query2 = "SELECT count(*) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundleidentifier."'";
-        $result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query2));
-
-        $totalcrashes = 0;
-        $numrows2 = mysql_num_rows($result2);
-        if ($numrows2 > 0) {
-            $row2 = mysql_fetch_row($result2);
-            $totalcrashes = $row2[0];
-            
-            mysql_free_result($result2);
-        }
+        $totalcrashes = crashRollupTotal("bundleidentifier = '".db_escape($bundleidentifier)."'");
+        if ($totalcrashes === false) die(end_with_result('Error in SQL '.$dbrolluptable));
         
         echo $totalcrashes . "</td>";
 
@@ -172,10 +179,12 @@ if ($numrows > 0) {
 		echo "</tr></table></form>";
 	}
 	
-	mysql_free_result($result);
+	db_free_result($result);
 }
 
-mysql_close($link);
+db_close();
+
+show_metadata_cache_stats();
 
 echo '</body></html>';
 
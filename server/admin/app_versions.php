@@ -41,6 +41,7 @@
 
 require_once('../config.php');
 require_once('common.inc');
+require_once('retention.inc');
 
 init_database();
 parse_parameters(',bundleidentifier,version,status,symbolicate,id,notify,deletecrashes,');
@@ -55,37 +56,36 @@ if (!isset($deletecrashes)) $deletecrashes = -1;
 
 // add the new app & version
 if ($version != "" && $deletecrashes == "1") {
-	$query = "DELETE FROM ".$dbsymbolicatetable." WHERE crashid in (select id from ".$dbcrashtable." where bundleidentifier = '".$bundleidentifier."' and version = '".$version."')";
-	$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
-
-	$query = "DELETE FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundleidentifier."' and version = '".$version."'";
-	$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
-	
-    $query = "DELETE FROM ".$dbgrouptable." WHERE bundleidentifier = '".$bundleidentifier."' and affected = '".$version."'";
-    $result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+	// cli/expire_crashes.php deletes the crashes and then the groups in the background
+	$error = deleteVersionQueue($bundleidentifier, $version);
+	if ($error != "") die(end_with_result('Error deleting version '.$version.': '.$error));
 } else if ($bundleidentifier != "" && $status != "" && $id == "" && $version != "") {
 	$query = "SELECT id FROM ".$dbversiontable." WHERE bundleidentifier = '".$bundleidentifier."' and version = '".$version."'";
-	$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+	$result = db_query($query) or die(end_with_result('Error in SQL '.$query));
 	
-	$numrows = mysql_num_rows($result);
+	$numrows = db_num_rows($result);
 	if ($numrows == 1)
 	{
-		$row = mysql_fetch_row($result);
+		$row = db_fetch_row($result);
 		$query2 = "UPDATE ".$dbversiontable." SET status = ".$status." WHERE id = ".$row[0];
-		$result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query2));
+		$result2 = db_query($query2) or die(end_with_result('Error in SQL '.$query2));
+		invalidateMetadataCache('versions');
 	} else if ($numrows == 0) {
 		// version is not available, so add it with status VERSION_STATUS_AVAILABLE
 		$query2 = "INSERT INTO ".$dbversiontable." (bundleidentifier, version, status) values ('".$bundleidentifier."', '".$version."', ".$status.")";
-		$result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query2));
+		$result2 = db_query($query2) or die(end_with_result('Error in SQL '.$query2));
+		invalidateMetadataCache('versions');
 	}
-	mysql_free_result($result);
+	db_free_result($result);
 } else if ($id != "" && ($status != "" || $notify != "")) {
 	$query = "UPDATE ".$dbversiontable." SET status = ".$status.", notify = ".$notify." WHERE id = ".$id;
-	$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+	$result = db_query($query) or die(end_with_result('Error in SQL '.$query));
+	invalidateMetadataCache('versions');
 } else if ($id != "" && $status == "") {
 	// delete a version
 	$query = "DELETE FROM ".$dbversiontable." WHERE id = '".$id."'";
-	$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+	$result = db_query($query) or die(end_with_result('Error in SQL '.$query));
+	invalidateMetadataCache('versions');
 }
 
 show_header('- App Versions');
@@ -111,63 +111,39 @@ echo "<td><div id=\"osdiv\" style=\"height:280px;width:310px; \"></div></td></tr
 // get the amount of crashes per system version
 $crashestime = true;
 
-$query = "SELECT timestamp FROM ".$dbcrashtable."  WHERE bundleidentifier = '".$bundleidentifier."' ORDER BY timestamp desc";
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
-$numrows = mysql_num_rows($result);
-if ($numrows > 0) {
-    while ($row = mysql_fetch_row($result)) {
-        $timestamp = $row[0];
-        
-        if ($timestamp != "" && ($timestampvalue = strtotime($timestamp)) !== false)
-		{
-            $timeindex = substr($timestamp, 0, 10);
-
-            if (!array_key_exists($timeindex, $crashvaluesarray)) {
-                $crashvaluesarray[$timeindex] = 0;
-            }
-            $crashvaluesarray[$timeindex]++;
-        }
-    }
-}
-mysql_free_result($result);
+// the charts and counts read the rollup table instead of the crashes
+$rollupwhere = "bundleidentifier = '".db_escape($bundleidentifier)."'";
+
+$crashvaluesarray = crashRollupCounts("DATE(hour)", $rollupwhere);
+if ($crashvaluesarray === false) die(end_with_result('Error in SQL '.$dbrolluptable));
 
 
 $osticks = "";
 $osvalues = "";
 $whereclause = "";
 
-$query2 = "SELECT systemversion, COUNT(systemversion) FROM ".$dbcrashtable.$whereclause." WHERE bundleidentifier = '".$bundleidentifier."' group by systemversion order by systemversion desc";
-$result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query2));
-$numrows2 = mysql_num_rows($result2);
-if ($numrows2 > 0) {
-	// get the status
-	while ($row2 = mysql_fetch_row($result2)) {
-		if ($osticks != "") $osticks = $osticks.", ";
-		$osticks .= "'".$row2[0]."'";
-		if ($osvalues != "") $osvalues = $osvalues.", ";
-		$osvalues .= $row2[1];
-	}
+$counts = crashRollupCounts("systemversion", $rollupwhere." AND systemversion != ''");
+if ($counts === false) die(end_with_result('Error in SQL '.$dbrolluptable));
+foreach ($counts as $systemversion => $amount) {
+	if ($osticks != "") $osticks = $osticks.", ";
+	$osticks .= "'".$systemversion."'";
+	if ($osvalues != "") $osvalues = $osvalues.", ";
+	$osvalues .= $amount;
 }
-mysql_free_result($result2);
 
 // get the amount of crashes per system version
 $crashestime = true;
 
 $platformticks = "";
 $platformvalues = "";
-$query = "SELECT platform, COUNT(platform) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundleidentifier."' AND platform != \"\" group by platform order by platform desc";
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
-$numrows = mysql_num_rows($result);
-if ($numrows > 0) {
-	// get the status
-	while ($row = mysql_fetch_row($result)) {
-		if ($platformticks != "") $platformticks = $platformticks.", ";
-		$platformticks .= "'".$row[0]."'";
-		if ($platformvalues != "") $platformvalues = $platformvalues.", ";
-		$platformvalues .= $row[1];
-	}
+$counts = crashRollupCounts("platform", $rollupwhere." AND platform != ''");
+if ($counts === false) die(end_with_result('Error in SQL '.$dbrolluptable));
+foreach ($counts as $platform => $amount) {
+	if ($platformticks != "") $platformticks = $platformticks.", ";
+	$platformticks .= "'".$platform."'";
+	if ($platformvalues != "") $platformvalues = $platformvalues.", ";
+	$platformvalues .= $amount;
 }
-mysql_free_result($result);
 
 echo '</table>';
 
@@ -226,12 +202,20 @@ if ($acceptallapps)
 else
 	$query = "SELECT bundleidentifier, version, status, notify, id FROM ".$dbversiontable." WHERE bundleidentifier = '".$bundleidentifier."' ORDER BY bundleidentifier asc, INET_ATON(SUBSTRING_INDEX(CONCAT(version, '.0.0.0'),  '.', 4)) desc, status desc";
 
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+$result = db_query($query) or die(end_with_result('Error in SQL '.$query));
 
-$numrows = mysql_num_rows($result);
+// the versions whose crashes are being deleted
+$deleting = array();
+$jobs = deleteVersionJobs($acceptallapps ? null : $bundleidentifier);
+if (is_array($jobs)) {
+	foreach ($jobs as $job)
+		$deleting[$job['bundleidentifier'].'/'.$job['affected']] = true;
+}
+
+$numrows = db_num_rows($result);
 if ($numrows > 0) {
 	// get the status
-	while ($row = mysql_fetch_row($result))
+	while ($row = db_fetch_row($result))
 	{
 		$bundleidentifier = $row[0];
 		$version = $row[1];
@@ -243,27 +227,19 @@ if ($numrows > 0) {
 		
 		// get the number of groups
 		$query2 = "SELECT count(*) FROM ".$dbgrouptable." WHERE bundleidentifier = '".$bundleidentifier."' and affected = '".$version."'";
-		$result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$$query2));
+		$result2 = db_query($query2) or die(end_with_result('Error in SQL '.$$query2));
 		
-		$numrows2 = mysql_num_rows($result2);
+		$numrows2 = db_num_rows($result2);
 		if ($numrows2 > 0) {
-			$row2 = mysql_fetch_row($result2);
+			$row2 = db_fetch_row($result2);
 			$groups = $row2[0];
 			
-			mysql_free_result($result2);
+			db_free_result($result2);
 		}
 
 		// get the total number of crashes
-		$query2 = "SELECT count(*) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundleidentifier."' and version = '".$version."'";
-		$result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query2));
-		
-		$numrows2 = mysql_num_rows($result2);
-		if ($numrows2 > 0) {
-			$row2 = mysql_fetch_row($result2);
-			$totalcrashes = $row2[0];
-			
-			mysql_free_result($result2);
-		}
+		$totalcrashes = crashRollupTotal("bundleidentifier = '".db_escape($bundleidentifier)."' AND version = '".db_escape($version)."'");
+		if ($totalcrashes === false) die(end_with_result('Error in SQL '.$dbrolluptable));
 		
 		echo "<form name='update".$id."' action='app_versions.php' method='get'><input type='hidden' name='id' value='".$id."'/><input type='hidden' name='bundleidentifier' value='".$bundleidentifier."'/>";
 		echo '<table>'.$cols;
@@ -300,7 +276,9 @@ if ($numrows > 0) {
 		
 		echo "</td><td>".$groups."</td><td>".$totalcrashes."</td><td>";
 		
-		if ($totalcrashes == 0 && $groups == 0) {			
+		if (isset($deleting[$bundleidentifier.'/'.$version])) {
+			echo "Deleting";
+		} else if ($totalcrashes == 0 && $groups == 0) {			
 			echo " <a href='app_versions.php?id=".$id."&bundleidentifier=".$bundleidentifier."' class='button' onclick='return confirm(\"Do you really want to delete this item?\");'>Delete</a>";
 		} else {
                 echo "<a href='app_versions.php?deletecrashes=1&bundleidentifier=".$bundleidentifier."&version=".$version."' class='button redButton' onclick='return confirm(\"Do you really want to delete all items?\");'>Delete Crashes</a>";
@@ -308,10 +286,43 @@ if ($numrows > 0) {
 		echo "</td></tr></table></form>";
 	}
 	
-	mysql_free_result($result);
+	db_free_result($result);
 }
 
-mysql_close($link);
+// the issues with the most crashes over all versions, their totals are kept up to date at ingest
+if (!$acceptallapps && $bundleidentifier != "") {
+	$cols = '<colgroup><col width="80"/><col width="80"/><col width="630"/><col width="160"/></colgroup>';
+	echo '<table>'.$cols;
+	echo "<tr><th>Count</th><th>Groups</th><th>Top Issues of all Versions</th><th>".create_link('All Issues', 'issues.php', true, 'bundleidentifier')."</th></tr>";
+
+	$query = "SELECT id, amount, groupcount, location, exception, reason FROM ".$dbissuetable." WHERE bundleidentifier = ? ORDER BY amount desc LIMIT 10";
+	$result = db_execute($query, "s", array($bundleidentifier)) or die(end_with_result('Error in SQL '.$query));
+	while ($row = db_fetch_row($result)) {
+		$reason = str_replace("No Reason found.", $row[4]." - ", $row[5]);
+		echo "<tr><td>".$row[1]."</td><td>".$row[2]."</td><td><b>".$row[3]."</b><br/><font color='#777'>".$reason."</font></td>";
+		echo "<td><a href='issues.php?bundleidentifier=".$bundleidentifier."&issueid=".$row[0]."' class='button'>Versions</a></td></tr>";
+	}
+	db_free_result($result);
+	echo '</table>';
+}
+
+// the rules which stack frames are skipped when grouping
+if ($bundleidentifier != "") {
+	$query = "SELECT count(*) FROM ".$dbframeruletable." WHERE bundleidentifier = ?";
+	$result = db_execute($query, "s", array($bundleidentifier)) or die(end_with_result('Error in SQL '.$query));
+	$row = db_fetch_row($result);
+	db_free_result($result);
+
+	$cols = '<colgroup><col width="790"/><col width="160"/></colgroup>';
+	echo '<table>'.$cols;
+	echo "<tr><th>Grouping</th><th>".create_link('Frame Rules', 'frame_rules.php', true, 'bundleidentifier')."</th></tr>";
+	echo "<tr><td>".$row[0]." frame rules skip stack frames when crashes are grouped</td><td></td></tr>";
+	echo '</table>';
+}
+
+db_close();
+
+show_metadata_cache_stats();
 
 ?>
 <script type="text/javascript">
@@ -36,17 +36,12 @@
 //
  
 require_once('../config.php');
-
-function end_with_result($result)
-{
-	return '<html><body>'.$result.'</body></html>'; 
-}
+require_once('common.inc');
 
 $allowed_args = ',id,';
 
-$link = mysql_connect($server, $loginsql, $passsql)
+$link = db_connect()
     or die(end_with_result('No database connection'));
-mysql_select_db($base) or die(end_with_result('No database connection'));
 
 foreach(array_keys($_GET) as $k) {
     $temp = ",$k,";
@@ -57,19 +52,21 @@ if (!isset($id)) $id = "";
 
 if ($id == "") die(end_with_result('Wrong parameters'));
 
-$query = "SELECT log FROM ".$dbcrashtable." WHERE id = ".$id;
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$dbversiontable));
+$query = "SELECT log, logcodec FROM ".$dbbodytable." WHERE crashid = ".$id;
+$result = db_query($query) or die(end_with_result('Error in SQL '.$dbversiontable));
 
-$numrows = mysql_num_rows($result);
+$numrows = db_num_rows($result);
 if ($numrows > 0) {
-	while ($row = mysql_fetch_row($result))
+	while ($row = db_fetch_row($result))
 	{
-		echo $row[0];
+		$log = crashLogDecode($row[0], $row[1]);
+		if ($log === false) die(end_with_result('Crash log can not be decompressed'));
+		echo $log;
 	}
-	mysql_free_result($result);
+	db_free_result($result);
 }
 
-mysql_close($link);
+db_close();
 
 
 ?>
\ No newline at end of file
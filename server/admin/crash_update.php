@@ -37,13 +37,13 @@
 //
 
 require_once('../config.php');
+require_once('common.inc');
 
 
 $allowed_args = ',id,log,';
 
-$link = mysql_connect($server, $loginsql, $passsql)
+$link = db_connect()
     or die('error');
-mysql_select_db($base) or die('error');
 
 foreach(array_keys($_POST) as $k) {
     $temp = ",$k,";
@@ -56,16 +56,31 @@ if (!isset($log)) $log = "";
 echo  $id." ".$log."\n";
 
 if ($id == "" || $log == "") {
-	mysql_close($link);
+	db_close();
 	die('error');
 }
 
-$query = "UPDATE ".$dbcrashtable." SET log = '".mysql_real_escape_string($log)."' WHERE id = ".$id;
-$result = mysql_query($query) or die('Error in SQL '.$dbcrashtable);
+list($logstored, $logcodec, $logsize) = crashLogEncode($log);
+$query = "UPDATE ".$dbbodytable." SET log = ?, logcodec = ?, logsize = ? WHERE crashid = ?";
+$result = db_execute($query, "biii", array($logstored, $logcodec, $logsize, $id)) or die('Error in SQL '.$dbbodytable);
 
 if ($result) {
 	$query = "UPDATE ".$dbsymbolicatetable." SET done = 1 WHERE crashid = ".$id;
-	$result = mysql_query($query) or die('Error in SQL '.$dbsymbolicatetable);
+	$result = db_query($query) or die('Error in SQL '.$dbsymbolicatetable);
+	
+	// with symbol names the group can be linked to the same crash of other versions
+	$query = "SELECT bundleidentifier FROM ".$dbcrashtable." WHERE id = ?";
+	$result2 = db_execute($query, "i", array($id)) or die('Error in SQL '.$dbcrashtable);
+	$row = db_fetch_row($result2);
+	db_free_result($result2);
+	
+	$filter = $row ? crashFrameFilter($row[0]) : null;
+	if ($filter === false) die('Error in SQL '.$dbframeruletable);
+	$groupingArray = crashLogGroupArray($log, $filter);
+	if ($result && linkSymbolicatedCrashIssue($id, $groupingArray) != "") $result = false;
+	
+	// the stored frames get their symbol names as well
+	if ($result && !updateCrashFrames($id, $log, $groupingArray)) $result = false;
 	
 	if ($result)
 		echo "success";
@@ -75,7 +90,7 @@ if ($result) {
 	echo "error";
 }
 
-mysql_close($link);
+db_close();
 
 
 ?>
\ No newline at end of file
@@ -63,15 +63,20 @@ if ($search != "" && $type != "") {
 	if ($type == SEARCH_TYPE_ID)
         $whereclause .= " AND id = '".$search."'";
     else if ($type == SEARCH_TYPE_DESCRIPTION)
-        $whereclause .= " AND description like '%".$search."%'";
-    else if ($type  == SEARCH_TYPE_CRASHLOG)
-        $whereclause .= " AND log like '%".$search."%'";
+        $whereclause .= " AND id IN (SELECT crashid FROM ".$dbbodytable." WHERE description like '%".$search."%')";
+    else if ($type  == SEARCH_TYPE_CRASHLOG) {
+        $crashids = crashLogSearch($bundleidentifier, $version, $search);
+        if ($crashids === false) die(end_with_result('Error in SQL '.$dbcrashtable));
+        $whereclause .= count($crashids) > 0 ? " AND id IN (".implode(",", $crashids).")" : " AND 0";
+    }
     else if ($type  == SEARCH_TYPE_CONTACT)
         $whereclause .= " AND contact like '%".$search."%'";
     else if ($type  == SEARCH_TYPE_USERID)
         $whereclause .= " AND userid like '%".$search."%'";
     else if ($type  == SEARCH_TYPE_USERNAME)
         $whereclause .= " AND username like '%".$search."%'";
+    else if ($type  == SEARCH_TYPE_SYMBOL)
+        $whereclause .= " AND id IN (SELECT crashid FROM ".$dbframetable." WHERE symbol like '".db_escape($search)."%')";
     if ($version != "")
     	$whereclause .= " AND version = '".$version."'";
 } else if ($groupid == "") {
@@ -111,18 +116,19 @@ $platformticks = "";
 
 $crashestime = false;
 $crashvaluesarray = array();
+$rollupchart = false;
 $crashvalues = "";
 
 if ($groupid !='') {
     $cols2 = '<colgroup><col width="280"/><col width="340"/><col width="340"/></colgroup>';
 
     $query = "SELECT location, exception, reason, description FROM ".$dbgrouptable." WHERE id = '".$groupid."'";
-    $result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+    $result = db_query($query) or die(end_with_result('Error in SQL '.$query));
 
-    $numrows = mysql_num_rows($result);
+    $numrows = db_num_rows($result);
     if ($numrows > 0) {
         // get the status
-        while ($row = mysql_fetch_row($result)) {
+        while ($row = db_fetch_row($result)) {
             $location = $row[0];
             $exception = $row[1];
             $reason = $row[2];
@@ -140,38 +146,34 @@ if ($groupid !='') {
 			
 			$osticks = "";
 			$osvalues = "";
-			$query2 = "SELECT systemversion, COUNT(systemversion) FROM ".$dbcrashtable.$whereclause." group by systemversion order by systemversion desc";
-			$result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query2));
-			$numrows2 = mysql_num_rows($result2);
-			if ($numrows2 > 0) {
-				// get the status
-				while ($row2 = mysql_fetch_row($result2)) {
-					if ($osticks != "") $osticks = $osticks.", ";
-					$osticks .= "'".$row2[0]."'";
-					if ($osvalues != "") $osvalues = $osvalues.", ";
-					$osvalues .= $row2[1];
-				}
+			// the charts and the amount read the rollup table instead of the crashes
+			$rollupwhere = "groupid = ".intval($groupid);
+			$crashvaluesarray = crashRollupCounts("DATE(hour)", $rollupwhere);
+			if ($crashvaluesarray === false) die(end_with_result('Error in SQL '.$dbrolluptable));
+			$rollupchart = true;
+			
+			$counts = crashRollupCounts("systemversion", $rollupwhere." AND systemversion != ''");
+			if ($counts === false) die(end_with_result('Error in SQL '.$dbrolluptable));
+			foreach ($counts as $systemversion => $amount) {
+				if ($osticks != "") $osticks = $osticks.", ";
+				$osticks .= "'".$systemversion."'";
+				if ($osvalues != "") $osvalues = $osvalues.", ";
+				$osvalues .= $amount;
 			}
-			mysql_free_result($result2);
 			
 			// get the amount of crashes per system version
 			$crashestime = true;
 			
 			$platformticks = "";
 			$platformvalues = "";
-			$query2 = "SELECT platform, COUNT(platform) FROM ".$dbcrashtable.$whereclause." AND platform != \"\" group by platform order by platform desc";
-			$result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query2));
-			$numrows2 = mysql_num_rows($result2);
-			if ($numrows2 > 0) {
-				// get the status
-				while ($row2 = mysql_fetch_row($result2)) {
-					if ($platformticks != "") $platformticks = $platformticks.", ";
-					$platformticks .= "'".$row2[0]."'";
-					if ($platformvalues != "") $platformvalues = $platformvalues.", ";
-					$platformvalues .= $row2[1];
-				}
+			$counts = crashRollupCounts("platform", $rollupwhere." AND platform != ''");
+			if ($counts === false) die(end_with_result('Error in SQL '.$dbrolluptable));
+			foreach ($counts as $platform => $amount) {
+				if ($platformticks != "") $platformticks = $platformticks.", ";
+				$platformticks .= "'".$platform."'";
+				if ($platformvalues != "") $platformvalues = $platformvalues.", ";
+				$platformvalues .= $amount;
 			}
-			mysql_free_result($result2);
 			
 			
 			
@@ -188,18 +190,11 @@ if ($groupid !='') {
             echo '</form></td></tr></table>';
             
             // get the amount of crashes
-            $amount = 0;
-            $query2 = "SELECT count(*) FROM ".$dbcrashtable.$whereclause;
-            $result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query2));
-            $numrows2 = mysql_num_rows($result2);
-            if ($numrows2 == 1) {
-                $row2 = mysql_fetch_row($result2);
-                $amount = $row2[0];
-            }
-            mysql_free_result($result2);
+            $amount = crashRollupTotal($rollupwhere);
+            if ($amount === false) die(end_with_result('Error in SQL '.$dbrolluptable));
         }
     }
-   	mysql_free_result($result);
+   	db_free_result($result);
 }
 
 echo '<table id="crashlist" class="hover">'.$cols;
@@ -208,12 +203,12 @@ echo '<tbody>';
 
 // get all crashes
 $query = "SELECT userid, username, contact, systemversion, timestamp, id, jailbreak, platform FROM ".$dbcrashtable.$whereclause." ORDER BY systemversion desc, timestamp desc";
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+$result = db_query($query) or die(end_with_result('Error in SQL '.$query));
 
-$numrows = mysql_num_rows($result);
+$numrows = db_num_rows($result);
 if ($numrows > 0) {
 	// get the status
-	while ($row = mysql_fetch_row($result)) {
+	while ($row = db_fetch_row($result)) {
 		$userid = $row[0];
 		$username = $row[1];
 		$contact = $row[2];
@@ -225,15 +220,15 @@ if ($numrows > 0) {
 				
 		$todo = 2;
 		$query2 = "SELECT done FROM ".$dbsymbolicatetable." WHERE crashid = ".$crashid;
-		$result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query));
+		$result2 = db_query($query2) or die(end_with_result('Error in SQL '.$query));
 
-		$numrows2 = mysql_num_rows($result2);
+		$numrows2 = db_num_rows($result2);
 		if ($numrows2 > 0)
 		{
-			$row2 = mysql_fetch_row($result2);
+			$row2 = db_fetch_row($result2);
 			$todo = $row2[0];
 		}
-		mysql_free_result($result2);
+		db_free_result($result2);
 		
 		$now = time();
 		
@@ -250,12 +245,13 @@ if ($numrows > 0) {
             else
                 $timestamp = "<font color='".$colorOther."'>".$timestamp."</font>";
           
-            // add the value to the chart stuff
-      
-            if (!array_key_exists($timeindex, $crashvaluesarray)) {
-                $crashvaluesarray[$timeindex] = 0;
+            // add the value to the chart stuff, unless it comes from the rollup table
+            if (!$rollupchart) {
+                if (!array_key_exists($timeindex, $crashvaluesarray)) {
+                    $crashvaluesarray[$timeindex] = 0;
+                }
+                $crashvaluesarray[$timeindex]++;
             }
-            $crashvaluesarray[$timeindex]++;
 		}
 
 		echo "<tr id='crashrow".$crashid."' valign='top' align='center' data-url='javascript:showCrashID(".$crashid.")'>";
@@ -295,7 +291,7 @@ if ($numrows > 0) {
 		echo "</tr>";
 	}
 	
-	mysql_free_result($result);
+	db_free_result($result);
 } else {
 	echo '<tr><td colspan="4">No data found</td></tr>';
 }
@@ -305,7 +301,7 @@ echo "<table>".$cols;
 echo "<tr><th colspan='2'>Description</th><th colspan='2'>Log</th></tr>";
 echo "<tr><td colspan='2'><div id='descriptionarea' class='short'></div></td><td colspan='2'><div id='logarea' class='log'></div></td></tr></table>";
 
-mysql_close($link);
+db_close();
 
 ?>
 <script type="text/javascript">
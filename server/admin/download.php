@@ -35,17 +35,12 @@
 //
 
 require_once('../config.php');
-
-function end_with_result($result)
-{
-	return '<html><body>'.$result.'</body></html>'; 
-}
+require_once('common.inc');
 
 $allowed_args = ',groupid,crashid,';
 
-$link = mysql_connect($server, $loginsql, $passsql)
+$link = db_connect()
     or die(end_with_result('No database connection'));
-mysql_select_db($base) or die(end_with_result('No database connection'));
 
 foreach(array_keys($_GET) as $k) {
     $temp = ",$k,";
@@ -59,22 +54,23 @@ if ($groupid == "" && $crashid == "") die(end_with_result('Wrong parameters'));
 
 $query = "";
 if ($groupid != "") {
-	$query = "SELECT userid, contact, systemversion, description, log, timestamp FROM ".$dbcrashtable." WHERE groupid = '".$groupid."' ORDER BY systemversion desc, timestamp desc LIMIT 1";
+	$query = "SELECT userid, contact, systemversion, description, log, timestamp, logcodec FROM ".$dbcrashtable." JOIN ".$dbbodytable." ON ".$dbbodytable.".crashid = ".$dbcrashtable.".id WHERE ".$dbcrashtable.".groupid = '".$groupid."' ORDER BY systemversion desc, timestamp desc LIMIT 1";
 } else {
-	$query = "SELECT userid, contact, systemversion, description, log, timestamp FROM ".$dbcrashtable." WHERE id = '".$crashid."' ORDER BY systemversion desc, timestamp desc LIMIT 1";
+	$query = "SELECT userid, contact, systemversion, description, log, timestamp, logcodec FROM ".$dbcrashtable." JOIN ".$dbbodytable." ON ".$dbbodytable.".crashid = ".$dbcrashtable.".id WHERE ".$dbcrashtable.".id = '".$crashid."'";
 }
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+$result = db_query($query) or die(end_with_result('Error in SQL '.$query));
 
-$numrows = mysql_num_rows($result);
+$numrows = db_num_rows($result);
 if ($numrows > 0) {
 	// get the status
-	$row = mysql_fetch_row($result);
+	$row = db_fetch_row($result);
 	$userid = $row[0];
 	$contact = $row[1];
 	$systemversion = $row[2];
 	$description = $row[3];
-	$log = $row[4];
+	$log = crashLogDecode($row[4], $row[6]);
 	$timestamp = $row[5];
+	if ($log === false) die(end_with_result('Crash log can not be decompressed'));
 	
 	// We'll be outputting a text file
 	header('Content-type: application/text');
@@ -83,11 +79,11 @@ if ($numrows > 0) {
 	header('Content-Disposition: attachment; filename="'.$timestamp.'.crash"');
 	echo $log;
 	
-	mysql_free_result($result);
+	db_free_result($result);
 } else {
 	echo '<html><head></head><body>Nothing found!</body></html>';
 }
 
-mysql_close($link);
+db_close();
 
 ?>
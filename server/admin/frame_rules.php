@@ -0,0 +1,107 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde & Kent Sutherland.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// This script shows and edits the frame rules of an application
+//
+// The rules decide which stack frames are skipped when the crashes of the
+// application are grouped. They apply to new crashes, existing crashes are
+// grouped by them when their version is regrouped.
+//
+
+require_once('../config.php');
+require_once('common.inc');
+
+init_database();
+parse_parameters(',bundleidentifier,id,type,value,');
+
+if (!isset($bundleidentifier)) $bundleidentifier = "";
+if (!isset($id)) $id = "";
+if (!isset($type)) $type = "";
+if (!isset($value)) $value = "";
+
+if ($bundleidentifier == "") die(end_with_result('Wrong parameters'));
+
+$query = "";
+if ($id != "") {
+	// delete a rule
+	$query = "DELETE FROM ".$dbframeruletable." WHERE id = ? AND bundleidentifier = ?";
+	$result = db_execute($query, "is", array($id, $bundleidentifier)) or die(end_with_result('Error in SQL '.$query));
+} else if ($type != "" && trim($value) != "") {
+	// add a rule
+	$query = "INSERT INTO ".$dbframeruletable." (bundleidentifier, type, value) values (?, ?, ?)";
+	$result = db_execute($query, "sis", array($bundleidentifier, $type, trim($value))) or die(end_with_result('Error in SQL '.$query));
+}
+if ($query != "")
+	invalidateMetadataCache('frame_rules');
+
+show_header('- Frame Rules');
+
+echo '<h2>';
+if (!$acceptallapps)
+	echo '<a href="app_name.php">Apps</a> - ';
+
+echo create_link($bundleidentifier, 'app_versions.php', false, 'bundleidentifier').' - '.create_link('Frame Rules', 'frame_rules.php', false, 'bundleidentifier').'</h2>';
+
+$ruletypes = array(FRAME_RULE_SKIP_IMAGE => 'Skip Image', FRAME_RULE_SKIP_SYMBOL => 'Skip Symbol Prefix', FRAME_RULE_SYSTEM_IMAGE => 'Treat Framework as System');
+
+$cols = '<colgroup><col width="250"/><col width="550"/><col width="150"/></colgroup>';
+echo '<table>'.$cols;
+echo "<tr><th>Rule</th><th>Image Name / Symbol Prefix</th><th>Actions</th></tr>";
+echo '</table>';
+
+echo "<form name='add_rule' action='frame_rules.php' method='get'>";
+echo "<input type='hidden' name='bundleidentifier' value='".$bundleidentifier."'/>";
+echo '<table>'.$cols;
+echo "<tr align='center'><td><select name='type'>";
+foreach ($ruletypes as $ruletype => $title)
+	add_option($title, $ruletype, FRAME_RULE_SKIP_SYMBOL);
+echo "</select></td>";
+echo "<td><input type='text' name='value' size='60' maxlength='250' placeholder='e.g. -[MyAssertionHandler '/></td>";
+echo "<td><button type='submit' class='button'>Add Rule</button></td></tr>";
+echo '</table></form>';
+
+$query = "SELECT id, type, value FROM ".$dbframeruletable." WHERE bundleidentifier = ? ORDER BY type, value";
+$result = db_execute($query, "s", array($bundleidentifier)) or die(end_with_result('Error in SQL '.$query));
+
+echo '<table>'.$cols;
+while ($row = db_fetch_row($result)) {
+	$title = isset($ruletypes[$row[1]]) ? $ruletypes[$row[1]] : 'Unknown';
+	echo "<tr align='center'><td>".$title."</td><td>".htmlspecialchars($row[2])."</td>";
+	echo "<td><a href='frame_rules.php?bundleidentifier=".$bundleidentifier."&id=".$row[0]."' class='button redButton' onclick='return confirm(\"Do you really want to delete this item?\");'>Delete</a></td></tr>";
+}
+db_free_result($result);
+echo '</table>';
+
+echo '<p class="message">The rules apply to new crashes. Re-Group a version to group its existing crashes by them.</p>';
+
+db_close();
+
+?>
@@ -67,27 +67,11 @@ $crashvaluesarray = array();
 $crashvalues = "";
 
 
-// get the amount of crashes over time
+// get the amount of crashes over time, the charts and counts read the rollup table instead of the crashes
+$rollupwhere = "bundleidentifier = '".db_escape($bundleidentifier)."' AND version = '".db_escape($version)."'";
 
-$query = "SELECT timestamp FROM ".$dbcrashtable."  WHERE bundleidentifier = '".$bundleidentifier."' AND version = '".$version."' ORDER BY timestamp desc";
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
-$numrows = mysql_num_rows($result);
-if ($numrows > 0) {
-  while ($row = mysql_fetch_row($result)) {
-    $timestamp = $row[0];
-        
-    if ($timestamp != "" && ($timestampvalue = strtotime($timestamp)) !== false)
-		{
-      $timeindex = substr($timestamp, 0, 10);
-
-      if (!array_key_exists($timeindex, $crashvaluesarray)) {
-        $crashvaluesarray[$timeindex] = 0;
-      }
-      $crashvaluesarray[$timeindex]++;
-    }
-  }
-}
-mysql_free_result($result);
+$crashvaluesarray = crashRollupCounts("DATE(hour)", $rollupwhere);
+if ($crashvaluesarray === false) die(end_with_result('Error in SQL '.$dbrolluptable));
 
 
 $cols2 = '<colgroup><col width="320"/><col width="320"/><col width="320"/></colgroup>';
@@ -104,38 +88,28 @@ $osticks = "";
 $osvalues = "";
 $whereclause = "";
 
-$query2 = "SELECT systemversion, COUNT(systemversion) FROM ".$dbcrashtable.$whereclause." WHERE bundleidentifier = '".$bundleidentifier."' AND version = '".$version."' group by systemversion order by systemversion desc";
-$result2 = mysql_query($query2) or die(end_with_result('Error in SQL '.$query2));
-$numrows2 = mysql_num_rows($result2);
-if ($numrows2 > 0) {
-	// get the status
-	while ($row2 = mysql_fetch_row($result2)) {
-		if ($osticks != "") $osticks = $osticks.", ";
-		$osticks .= "'".$row2[0]."'";
-		if ($osvalues != "") $osvalues = $osvalues.", ";
-		$osvalues .= $row2[1];
-	}
+$counts = crashRollupCounts("systemversion", $rollupwhere." AND systemversion != ''");
+if ($counts === false) die(end_with_result('Error in SQL '.$dbrolluptable));
+foreach ($counts as $systemversion => $amount) {
+	if ($osticks != "") $osticks = $osticks.", ";
+	$osticks .= "'".$systemversion."'";
+	if ($osvalues != "") $osvalues = $osvalues.", ";
+	$osvalues .= $amount;
 }
-mysql_free_result($result2);
 
 // get the amount of crashes per system version
 $crashestime = true;
 
 $platformticks = "";
 $platformvalues = "";
-$query = "SELECT platform, COUNT(platform) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundleidentifier."' AND version = '".$version."' AND platform != \"\" group by platform order by platform desc";
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
-$numrows = mysql_num_rows($result);
-if ($numrows > 0) {
-	// get the status
-	while ($row = mysql_fetch_row($result)) {
-		if ($platformticks != "") $platformticks = $platformticks.", ";
-		$platformticks .= "'".$row[0]."'";
-		if ($platformvalues != "") $platformvalues = $platformvalues.", ";
-		$platformvalues .= $row[1];
-	}
+$counts = crashRollupCounts("platform", $rollupwhere." AND platform != ''");
+if ($counts === false) die(end_with_result('Error in SQL '.$dbrolluptable));
+foreach ($counts as $platform => $amount) {
+	if ($platformticks != "") $platformticks = $platformticks.", ";
+	$platformticks .= "'".$platform."'";
+	if ($platformvalues != "") $platformvalues = $platformvalues.", ";
+	$platformvalues .= $amount;
 }
-mysql_free_result($result);
 echo '</table>';
 
 
@@ -161,14 +135,16 @@ echo '</table>';
 
 echo '<div id="groups">';
 
-// get all groups
-$query = "SELECT id, amount, latesttimestamp, location, exception, reason, description FROM ".$dbgrouptable." WHERE bundleidentifier = '".$bundleidentifier."' AND affected = '".$version."' ORDER BY amount desc, location asc";
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+// get all groups, with the totals of the issue they are linked to
+$query = "SELECT ".$dbgrouptable.".id, ".$dbgrouptable.".amount, ".$dbgrouptable.".latesttimestamp, ".$dbgrouptable.".location, ".$dbgrouptable.".exception, ".$dbgrouptable.".reason, ".$dbgrouptable.".description, ".
+    $dbgrouptable.".issueid, ".$dbissuetable.".amount, ".$dbissuetable.".groupcount FROM ".$dbgrouptable." LEFT JOIN ".$dbissuetable." ON ".$dbissuetable.".id = ".$dbgrouptable.".issueid ".
+    "WHERE ".$dbgrouptable.".bundleidentifier = '".$bundleidentifier."' AND ".$dbgrouptable.".affected = '".$version."' ORDER BY ".$dbgrouptable.".amount desc, ".$dbgrouptable.".location asc";
+$result = db_query($query) or die(end_with_result('Error in SQL '.$query));
 
-$numrows = mysql_num_rows($result);
+$numrows = db_num_rows($result);
 if ($numrows > 0) {
 	// get the status
-	while ($row = mysql_fetch_row($result)) {
+	while ($row = db_fetch_row($result)) {
 		$groupid = $row[0];
 		$amount = $row[1];
 		$lastupdate = $row[2];
@@ -176,6 +152,9 @@ if ($numrows > 0) {
 		$exception = $row[4];
 		$reason = $row[5];
 		$description = $row[6];
+		$issueid = $row[7];
+		$issueamount = $row[8];
+		$issuegroups = $row[9];
         
         $reason = str_replace("No Reason found.", $exception." - ", $reason);
 		
@@ -206,6 +185,8 @@ if ($numrows > 0) {
         echo "</td>";
         echo "<td>";
 		echo "<a href='actionapi.php?action=downloadcrashid&groupid=".$groupid."' class='button'>Download</a> ";
+		if ($issueid > 0)
+			echo "<a href='issues.php?bundleidentifier=".$bundleidentifier."&issueid=".$issueid."' class='button' title='".$issueamount." crashes in ".$issuegroups." groups'>All Versions: ".$issueamount."</a> ";
 		$issuelink = currentPageURL();
 		$issuelink = substr($issuelink, 0, strrpos($issuelink, "/")+1);
 		echo create_issue($bundleidentifier, $issuelink.'crashes.php?groupid='.$groupid.'&bundleidentifier='.$bundleidentifier.'&version='.$version);
@@ -215,29 +196,22 @@ if ($numrows > 0) {
 		echo '</form>';
 	}
 	
-	mysql_free_result($result);
+	db_free_result($result);
 }
 
 // get all crash reports not assigned to groups
-$query = "SELECT count(*) FROM ".$dbcrashtable." WHERE groupid = 0 and bundleidentifier = '".$bundleidentifier."' AND version = '".$version."'";
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$dbcrashtable));
-
-$numrows = mysql_num_rows($result);
-if ($numrows > 0) {
-	$row = mysql_fetch_row($result);
-	$amount = $row[0];
-	if ($amount > 0) {
-        echo '<table class="hover">'.$cols;
-		echo "<tr class='clickableRow' data-url='crashes.php?bundleidentifier=".$bundleidentifier."&version=".$version."'>";
-		echo '<td>'.$amount.'</td><td>Ungrouped</td><td></td>';
-        echo "<td><a href='regroup.php?bundleidentifier=".$bundleidentifier."&version=".$version."' class='button'>Re-Group</a>";
-		echo "<a href='groups.php?bundleidentifier=".$bundleidentifier."&version=".$version."&groupid=0' class='button redButton' onclick='return confirm(\"Do you really want to delete this item?\");'>Delete</a></td></tr>";
-		echo '</table>';
-	}
-	mysql_free_result($result);
+$amount = crashRollupTotal($rollupwhere." AND groupid = 0");
+if ($amount === false) die(end_with_result('Error in SQL '.$dbrolluptable));
+if ($amount > 0) {
+    echo '<table class="hover">'.$cols;
+	echo "<tr class='clickableRow' data-url='crashes.php?bundleidentifier=".$bundleidentifier."&version=".$version."'>";
+	echo '<td>'.$amount.'</td><td>Ungrouped</td><td></td>';
+    echo "<td><a href='regroup.php?bundleidentifier=".$bundleidentifier."&version=".$version."' class='button'>Re-Group</a>";
+	echo "<a href='groups.php?bundleidentifier=".$bundleidentifier."&version=".$version."&groupid=0' class='button redButton' onclick='return confirm(\"Do you really want to delete this item?\");'>Delete</a></td></tr>";
+	echo '</table>';
 }
 
-mysql_close($link);
+db_close();
 
 ?>
 </div>
@@ -0,0 +1,129 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde & Kent Sutherland.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// This script shows the issues of an application
+//
+// An issue links the crash groups of all versions whose crashes happen at the
+// same symbols of the app. Without an issue id the issues of the application
+// are listed with their total amount of crashes, with an issue id the crash
+// groups of the issue are listed with their version.
+//
+
+require_once('../config.php');
+require_once('common.inc');
+
+init_database();
+parse_parameters(',bundleidentifier,issueid,');
+
+if (!isset($bundleidentifier)) $bundleidentifier = "";
+if (!isset($issueid)) $issueid = "";
+
+if ($bundleidentifier == "") die(end_with_result('Wrong parameters'));
+
+show_header('- Issues');
+
+echo '<h2>';
+if (!$acceptallapps)
+	echo '<a href="app_name.php">Apps</a> - ';
+
+echo create_link($bundleidentifier, 'app_versions.php', false, 'bundleidentifier').' - '.create_link('Issues', 'issues.php', false, 'bundleidentifier').'</h2>';
+
+function show_timestamp($lastupdate) {
+	global $color24h, $color48h, $color72h, $colorOther;
+
+	if ($lastupdate == 0) return "-";
+
+	$timestring = date("Y-m-d H:i:s", $lastupdate);
+	if (time() - $lastupdate < 60*24*24)
+		return "<font color='".$color24h."'>".$timestring."</font>";
+	else if (time() - $lastupdate < 60*24*24*2)
+		return "<font color='".$color48h."'>".$timestring."</font>";
+	else if (time() - $lastupdate < 60*24*24*3)
+		return "<font color='".$color72h."'>".$timestring."</font>";
+	else
+		return "<font color='".$colorOther."'>".$timestring."</font>";
+}
+
+if ($issueid == "") {
+	$cols = '<colgroup><col width="80"/><col width="80"/><col width="620"/><col width="180"/></colgroup>';
+
+	echo '<table>'.$cols;
+	echo "<tr><th>Count</th><th>Groups</th><th>Description</th><th>Last Crash</th></tr>";
+	echo '</table>';
+
+	// the issues are kept with their totals, so this does not touch any crash
+	$query = "SELECT id, amount, groupcount, latesttimestamp, location, exception, reason FROM ".$dbissuetable." WHERE bundleidentifier = ? ORDER BY amount desc";
+	$result = db_execute($query, "s", array($bundleidentifier)) or die(end_with_result('Error in SQL '.$query));
+
+	while ($row = db_fetch_row($result)) {
+		$reason = str_replace("No Reason found.", $row[5]." - ", $row[6]);
+
+		echo '<table class="hover">'.$cols;
+		echo "<tr class='clickableRow' data-url='issues.php?bundleidentifier=".$bundleidentifier."&issueid=".$row[0]."'>";
+		echo "<td>".$row[1]."</td><td>".$row[2]."</td>";
+		echo "<td><b>".$row[4]."</b><br/><font color='#777'>".$reason."</font></td>";
+		echo "<td>".show_timestamp($row[3])."</td></tr>";
+		echo '</table>';
+	}
+	db_free_result($result);
+} else {
+	$cols = '<colgroup><col width="80"/><col width="80"/><col width="620"/><col width="180"/></colgroup>';
+
+	echo '<table>'.$cols;
+	echo "<tr><th>Version</th><th>Count</th><th>Description</th><th>Last Crash</th></tr>";
+	echo '</table>';
+
+	$query = "SELECT id, affected, amount, latesttimestamp, location, exception, reason, description FROM ".$dbgrouptable." WHERE issueid = ? AND bundleidentifier = ? ORDER BY INET_ATON(SUBSTRING_INDEX(CONCAT(affected, '.0.0.0'),  '.', 4)) desc";
+	$result = db_execute($query, "is", array($issueid, $bundleidentifier)) or die(end_with_result('Error in SQL '.$query));
+
+	while ($row = db_fetch_row($result)) {
+		$reason = str_replace("No Reason found.", $row[5]." - ", $row[6]);
+
+		echo '<table class="hover">'.$cols;
+		echo "<tr class='clickableRow' data-url='crashes.php?groupid=".$row[0]."&bundleidentifier=".$bundleidentifier."&version=".$row[1]."'>";
+		echo "<td>".$row[1]."</td><td>".$row[2]."</td>";
+		echo "<td><b>".$row[4]."</b><br/><font color='#777'>".$reason."<br/><i>".$row[7]."</i></font></td>";
+		echo "<td>".show_timestamp($row[3])."</td></tr>";
+		echo '</table>';
+	}
+	db_free_result($result);
+}
+
+db_close();
+
+?>
+<script type="text/javascript">
+$(document).ready(function(){
+    $(".clickableRow").click(function() {
+        window.document.location = $(this).data("url");
+    });
+});
+</script>
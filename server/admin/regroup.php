@@ -29,19 +29,22 @@
 	 */
 
 //
-// Download a crash
+// Regroup the crashes of a version
 //
-// This script downloads a given crash to a local file
+// This script regroups the crashes of a group of a version, by default the
+// ungrouped ones, using the engine in regroup.inc. Each request works for a
+// limited time and then reloads itself, which continues the regroup where the
+// last request stopped. Once all crashes are done it shows the groups again.
 //
 
 require_once('../config.php');
 require_once('common.inc');
+require_once('regroup.inc');
 
 $allowed_args = ',bundleidentifier,version,groupid,';
 
-$link = mysql_connect($server, $loginsql, $passsql)
+$link = db_connect()
     or die(end_with_result('No database connection'));
-mysql_select_db($base) or die(end_with_result('No database connection'));
 
 foreach(array_keys($_GET) as $k) {
     $temp = ",$k,";
@@ -54,45 +57,30 @@ if (!isset($groupid)) $groupid = "0";
 
 if ($bundleidentifier == "" || $version == "") die(end_with_result('Wrong parameters'));
 
-$query1 = "SELECT id, applicationname FROM ".$dbcrashtable." WHERE groupid = '".$groupid."' and version = '".$version."' and bundleidentifier = '".$bundleidentifier."'";
-$result1 = mysql_query($query1) or die(end_with_result('Error in SQL '.$query1));
+// stop well before the request times out, the next request continues
+$seconds = 20;
+$limit = intval(ini_get('max_execution_time'));
+if ($limit > 0) $seconds = min($seconds, max(1, (int)($limit / 2)));
 
-$numrows1 = mysql_num_rows($result1);
-if ($numrows1 > 0) {
-    // get the status
-    while ($row1 = mysql_fetch_row($result1)) {
-        $crashid = $row1[0];
-        $applicationname = $row1[1];
-	    
-	    // get the log data
-        $logdata = "";
+$job = regroupVersion($bundleidentifier, $version, intval($groupid), $seconds);
+if (!is_array($job)) die(end_with_result($job));
 
-   	    $query = "SELECT log FROM ".$dbcrashtable." WHERE id = '".$crashid."' ORDER BY systemversion desc, timestamp desc LIMIT 1";
-        $result = mysql_query($query) or die(end_with_result('Error in SQL '.$query));
+db_close();
 
-        $numrows = mysql_num_rows($result);
-        if ($numrows > 0) {
-            // get the status
-            $row = mysql_fetch_row($result);
-            $logdata = $row[0];
-	
-            mysql_free_result($result);
-        }
-        
-        $crash["bundleidentifier"] = $bundleidentifier;
-        $crash["version"] = $version;
-        $crash["logdata"] = $logdata;
-        $crash["id"] = $crashid;
-        $error = groupCrashReport($crash, $link, NOTIFY_OFF);
-        if ($error != "") {
-            die(end_with_result($error));
-        }        
-    }
-	    
-    mysql_free_result($result1);
+if (empty($job['done'])) {
+    $url = "regroup.php?bundleidentifier=".urlencode($bundleidentifier)."&version=".urlencode($version)."&groupid=".intval($groupid);
+?>
+<html>
+<head>
+    <META http-equiv="refresh" content="0;URL=<?php echo $url ?>">
+</head>
+<body>
+Regrouped <?php echo $job['processed'] ?> of <?php echo $job['total'] ?> crashes...
+</body>
+</html>
+<?php
+    exit;
 }
-
-mysql_close($link);
 ?>
 <html>
 <head>
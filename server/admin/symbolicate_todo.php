@@ -37,17 +37,12 @@
 //
  
 require_once('../config.php');
-
-function end_with_result($result)
-{
-	return '<html><body>'.$result.'</body></html>'; 
-}
+require_once('common.inc');
 
 $allowed_args = ',';
 
-$link = mysql_connect($server, $loginsql, $passsql)
+$link = db_connect()
     or die(end_with_result('No database connection'));
-mysql_select_db($base) or die(end_with_result('No database connection'));
 
 foreach(array_keys($_GET) as $k) {
     $temp = ",$k,";
@@ -57,11 +52,11 @@ foreach(array_keys($_GET) as $k) {
 $crashids = "";
 
 $query = "SELECT crashid FROM ".$dbsymbolicatetable." WHERE done = 0";
-$result = mysql_query($query) or die(end_with_result('Error in SQL '.$dbsymbolicatetable));
+$result = db_query($query) or die(end_with_result('Error in SQL '.$dbsymbolicatetable));
 
-$numrows = mysql_num_rows($result);
+$numrows = db_num_rows($result);
 if ($numrows > 0) {
-	while ($row = mysql_fetch_row($result))
+	while ($row = db_fetch_row($result))
 	{
 		if ($crashids != '')
 			$crashids .= ',';
@@ -69,10 +64,10 @@ if ($numrows > 0) {
 		$crashids .= $row[0];
 
 	}
-	mysql_free_result($result);
+	db_free_result($result);
 }
 
-mysql_close($link);
+db_close();
 
 echo $crashids;
 ?>
\ No newline at end of file
@@ -0,0 +1,260 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Measure the crash lists of the admin UI on a big database
+//
+// Runs the queries crashes.php, groups.php and app_versions.php use to list
+// crashes and reports the time of each, the buffer pool pages it touched and
+// the bytes InnoDB read from disk. Run it once before and once after applying
+// 010_crash_body.sql to compare the lists with the logs inline and in
+// crash_body, or 013_crash_rollup.sql to compare the charts and counts read
+// from the crashes and from crash_rollup. The status counters are global, so
+// nothing else should run on the database configured in config.php.
+//
+// Usage: php admin_lists.php --populate=1000000
+//        php admin_lists.php [options]
+//        php admin_lists.php --compare=before.json after.json
+//
+// --populate          add that many synthetic crashes to the database first, to
+//                     whichever schema it has
+// --bundleidentifier  the app whose lists are measured, de.buzzworks.QuincyDemo by default
+// --versions          versions the crashes are spread over, 10 by default
+// --groups            crash groups per version, 50 by default
+// --runs              times each query runs, the median is reported, 5 by default
+// --output            file the report is saved to as JSON
+// --compare           print the differences of two saved reports
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+require_once(dirname(__FILE__).'/crashgen.inc');
+
+$options = getopt('', array('populate:', 'bundleidentifier:', 'versions:', 'groups:', 'runs:', 'output:', 'compare:'));
+
+function listsCompare($before, $after) {
+  foreach ($after as $name => $new) {
+    if (!is_array($new)) continue;
+    foreach ($new as $metric => $value) {
+      $old = isset($before[$name][$metric]) ? $before[$name][$metric] : null;
+      $change = ($old !== null && $old != 0) ? sprintf("%+.1f%%", ($value - $old) / $old * 100) : "";
+      printf("%-28s %-14s %14s %14s %10s\n", $name, $metric, $old === null ? "-" : $old, $value, $change);
+    }
+  }
+}
+
+if (isset($options['compare'])) {
+  $files = array($options['compare'], end($argv));
+  $reports = array();
+  foreach ($files as $file) {
+    $reports[] = json_decode(@file_get_contents($file), true);
+    if (!is_array(end($reports))) die("Could not read ".$file."\n");
+  }
+  listsCompare($reports[0], $reports[1]);
+  exit;
+}
+
+$bundleidentifier = isset($options['bundleidentifier']) ? $options['bundleidentifier'] : 'de.buzzworks.QuincyDemo';
+$versions = isset($options['versions']) ? max(1, intval($options['versions'])) : 10;
+$groups = isset($options['groups']) ? max(1, intval($options['groups'])) : 50;
+$runs = isset($options['runs']) ? max(1, intval($options['runs'])) : 5;
+
+if (!db_connect(false)) die("No database connection\n");
+
+function listsValue($query) {
+  $result = db_query($query);
+  if (!$result) die("Error in SQL ".$query."\n");
+  $row = db_fetch_row($result);
+  db_free_result($result);
+
+  return $row ? $row[0] : null;
+}
+
+function listsStatus() {
+  $status = array();
+  $result = db_query("SHOW GLOBAL STATUS WHERE Variable_name IN ('Innodb_buffer_pool_read_requests', 'Innodb_buffer_pool_reads', 'Innodb_data_read')");
+  if (!$result) die("Error in SQL SHOW GLOBAL STATUS\n");
+  while ($row = db_fetch_row($result))
+    $status[$row[0]] = floatval($row[1]);
+  db_free_result($result);
+
+  return $status;
+}
+
+/**
+ * Add synthetic crashes, with the logs inline before 010_crash_body.sql and in crash_body after it
+ *
+ * The crashes of one crash site share their stored log, compressing a million logs
+ * would take longer than the measurement. Ids are given explicitly, so the bodies
+ * don't depend on the auto increment lock mode.
+ */
+function listsPopulate($count, $bundleidentifier, $versions, $groups, $rollup) {
+  global $dbcrashtable, $dbgrouptable, $dbbodytable;
+
+  $inline = (listsValue("SHOW COLUMNS FROM ".$dbcrashtable." LIKE 'log'") !== null);
+  $shape = benchCrashOptions(array('bundleidentifier' => $bundleidentifier, 'groups' => $groups, 'seed' => uniqid()));
+
+  // the groups of each version, created like groupCrashReport() does with fingerprint version 1
+  $groupids = array();
+  for ($version = 0; $version < $versions; $version++) {
+    for ($site = 0; $site < $groups; $site++) {
+      $pattern = "bench site ".$site;
+      $query = "INSERT INTO ".$dbgrouptable." (bundleidentifier, affected, pattern, fingerprint, fingerprintversion, location, exception, reason, amount, latesttimestamp) values ('".
+        db_escape($bundleidentifier)."', '1.".$version."', '".$pattern."', ".hexdec(substr(md5($shape['seed'].$pattern), 0, 12)).", 1, '".$pattern."', 'SIGABRT', '', 0, 0)";
+      if (!db_query($query)) die("Error in SQL ".$query."\n");
+      $groupids[$version][$site] = db_insert_id();
+    }
+  }
+
+  $logs = array();
+  for ($site = 0; $site < $groups; $site++)
+    $logs[$site] = crashLogEncode(benchCrashLog($shape, $site));
+
+  $crashid = intval(listsValue("SELECT MAX(id) FROM ".$dbcrashtable)) + 1;
+  $platforms = array('iPhone5,2', 'iPhone6,1', 'iPhone6,2', 'iPad4,1');
+  $systems = array('7.0.4', '7.1', '7.1.1', '7.1.2');
+  $start = time() - $count;
+
+  for ($done = 0; $done < $count; ) {
+    $crashes = array();
+    $bodies = array();
+    for ($i = 0; $i < 200 && $done < $count; $i++, $done++, $crashid++) {
+      $version = $done % $versions;
+      $site = intval($done / $versions) % $groups;
+      $log = $logs[$site];
+      $values = "(".$crashid.", 'user".($done % 5000)."', '', '', '".$systems[$done % count($systems)]."', '".$platforms[$done % count($platforms)]."', '".db_escape($bundleidentifier)."', 'QuincyDemo', '1.".$version."', '1.".$version."', ".
+        "FROM_UNIXTIME(".($start + $done)."), ".$groupids[$version][$site].", 0, '".benchUUID($shape['seed'].'|'.$done)."'";
+      $body = "'', '".db_escape($log[0])."', ".$log[1].", ".$log[2];
+      if ($inline) {
+        $crashes[] = $values.", ".$body.")";
+      } else {
+        $crashes[] = $values.")";
+        $bodies[] = "(".$crashid.", ".$body.")";
+      }
+    }
+
+    $columns = "id, userid, username, contact, systemversion, platform, bundleidentifier, applicationname, senderversion, version, timestamp, groupid, jailbreak, uuid";
+    if (!db_query("INSERT INTO ".$dbcrashtable." (".$columns.($inline ? ", description, log, logcodec, logsize" : "").") values ".implode(", ", $crashes))) die("Error in SQL ".$dbcrashtable."\n");
+    if (!$inline && !db_query("INSERT INTO ".$dbbodytable." (crashid, description, log, logcodec, logsize) values ".implode(", ", $bodies))) die("Error in SQL ".$dbbodytable."\n");
+
+    if ($done % 10000 == 0) echo "\r".$done." crashes";
+  }
+  echo "\r".$count." crashes added".($inline ? " with their logs in ".$dbcrashtable : " with their logs in ".$dbbodytable)."\n";
+
+  $query = "UPDATE ".$dbgrouptable." SET amount = (SELECT COUNT(*) FROM ".$dbcrashtable." WHERE groupid = ".$dbgrouptable.".id), latesttimestamp = UNIX_TIMESTAMP() WHERE bundleidentifier = '".db_escape($bundleidentifier)."'";
+  if (!db_query($query)) die("Error in SQL ".$query."\n");
+
+  if ($rollup && crashRollupRebuild($bundleidentifier) != "") die("Error in SQL ".$GLOBALS['dbrolluptable']."\n");
+}
+
+// crash_rollup only exists after 013_crash_rollup.sql
+$rollup = (listsValue("SHOW TABLES LIKE '".db_escape($dbrolluptable)."'") !== null);
+
+if (isset($options['populate'])) listsPopulate(max(1, intval($options['populate'])), $bundleidentifier, $versions, $groups, $rollup);
+
+// the latest version and its biggest group, like an admin looks at them
+$bundle = db_escape($bundleidentifier);
+$version = listsValue("SELECT version FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundle."' ORDER BY timestamp desc LIMIT 1");
+if ($version === null) die("No crashes of ".$bundleidentifier.", add some with --populate\n");
+$version = db_escape($version);
+$groupid = intval(listsValue("SELECT id FROM ".$dbgrouptable." WHERE bundleidentifier = '".$bundle."' AND affected = '".$version."' ORDER BY amount desc LIMIT 1"));
+
+$queries = array(
+  'crashes.php group' => "SELECT userid, username, contact, systemversion, timestamp, id, jailbreak, platform FROM ".$dbcrashtable." WHERE groupid = ".$groupid." ORDER BY systemversion desc, timestamp desc",
+  'crashes.php ungrouped' => "SELECT userid, username, contact, systemversion, timestamp, id, jailbreak, platform FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundle."' AND version = '".$version."' AND groupid = 0 ORDER BY systemversion desc, timestamp desc",
+  'groups.php timestamps' => "SELECT timestamp FROM ".$dbcrashtable."  WHERE bundleidentifier = '".$bundle."' AND version = '".$version."' ORDER BY timestamp desc",
+  'groups.php platforms' => "SELECT platform, COUNT(platform) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundle."' AND version = '".$version."' AND platform != \"\" group by platform order by platform desc",
+  'groups.php ungrouped' => "SELECT count(*) FROM ".$dbcrashtable." WHERE groupid = 0 and bundleidentifier = '".$bundle."' AND version = '".$version."'",
+  'app_versions.php timestamps' => "SELECT timestamp FROM ".$dbcrashtable."  WHERE bundleidentifier = '".$bundle."' ORDER BY timestamp desc",
+  'app_versions.php platforms' => "SELECT platform, COUNT(platform) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$bundle."' AND platform != \"\" group by platform order by platform desc"
+);
+
+// the charts and counts read the rollup table once it exists, under the same names so --compare shows both
+if ($rollup) {
+  $counts = "SUM(amount) FROM ".$dbrolluptable." WHERE ";
+  $queries['groups.php timestamps'] = "SELECT DATE(hour), ".$counts."bundleidentifier = '".$bundle."' AND version = '".$version."' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc";
+  $queries['groups.php platforms'] = "SELECT platform, ".$counts."bundleidentifier = '".$bundle."' AND version = '".$version."' AND platform != '' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc";
+  $queries['groups.php ungrouped'] = "SELECT ".$counts."bundleidentifier = '".$bundle."' AND version = '".$version."' AND groupid = 0";
+  $queries['app_versions.php timestamps'] = "SELECT DATE(hour), ".$counts."bundleidentifier = '".$bundle."' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc";
+  $queries['app_versions.php platforms'] = "SELECT platform, ".$counts."bundleidentifier = '".$bundle."' AND platform != '' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc";
+}
+
+$report = array('date' => date('c'), 'bundleidentifier' => $bundleidentifier, 'runs' => $runs);
+
+// the size of the tables, crash_body only exists after 010_crash_body.sql
+$result = db_query("SELECT table_name, data_length, index_length FROM information_schema.tables WHERE table_schema = DATABASE() AND table_name IN ('".db_escape($dbcrashtable)."', '".db_escape($dbbodytable)."', '".db_escape($dbrolluptable)."')");
+if (!$result) die("Error in SQL information_schema\n");
+while ($row = db_fetch_row($result))
+  $report[$row[0]] = array('data_mb' => round($row[1] / 1048576, 1), 'index_mb' => round($row[2] / 1048576, 1));
+db_free_result($result);
+
+foreach ($queries as $name => $query) {
+  $times = array();
+  $before = listsStatus();
+  for ($run = 0; $run < $runs; $run++) {
+    $start = microtime(true);
+    $result = db_query($query);
+    if (!$result) die("Error in SQL ".$query."\n");
+    $rows = 0;
+    while (db_fetch_row($result)) $rows++;
+    db_free_result($result);
+    $times[] = (microtime(true) - $start) * 1000;
+  }
+  $after = listsStatus();
+  $first = $times[0];
+  sort($times);
+
+  // the first run may read from disk, the others show the lists with a warm buffer pool
+  $report[$name] = array(
+    'rows' => $rows,
+    'median_ms' => round($times[intval(count($times) / 2)], 1),
+    'first_ms' => round($first, 1),
+    'page_reads_per_run' => round(($after['Innodb_buffer_pool_read_requests'] - $before['Innodb_buffer_pool_read_requests']) / $runs),
+    'disk_reads' => round($after['Innodb_buffer_pool_reads'] - $before['Innodb_buffer_pool_reads']),
+    'disk_mb' => round(($after['Innodb_data_read'] - $before['Innodb_data_read']) / 1048576, 1)
+  );
+}
+
+foreach ($report as $name => $value) {
+  if (!is_array($value)) {
+    printf("%-28s %s\n", $name, $value);
+    continue;
+  }
+  $parts = array();
+  foreach ($value as $metric => $number) $parts[] = $metric." ".$number;
+  printf("%-28s %s\n", $name, implode(", ", $parts));
+}
+
+if (isset($options['output']))
+  file_put_contents($options['output'], json_encode($report, defined('JSON_PRETTY_PRINT') ? JSON_PRETTY_PRINT : 0)."\n");
+
+?>
@@ -0,0 +1,316 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Compare crashLogGroupArrayPHP() with the regular expression based parser it
+// replaced, and with quincy_parse_crash() if the extension in ext/quincy is loaded
+//
+// The results have to be identical for every log of the corpus, which is made of
+// synthetic logs of about 100KB (as written, with CRLF line breaks and cut in half)
+// and of all crash log files given on the command line.
+//
+// The cost of frame rules is measured with crashLogGroupArray() and a filter of
+// many rules that match none of the frames, which has to give the same results
+// as no filter at all.
+//
+// Usage: php crashlog_parse.php [--logs=N] [--iterations=N] [--rules=N] [crash log files...]
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+require_once(dirname(__FILE__).'/crashgen.inc');
+
+// the implementation before the single pass section scan, kept as the reference
+
+function legacyParseThread($regEx, $data) {
+  $stackTrace = array();
+  preg_match($regEx, $data, $matches);
+
+  if (is_array($matches) && count($matches) >= 2) {
+    $lines = explode("\n", $matches[1]);
+    foreach ($lines as $line) {
+      preg_match("/^(\d+)\s+(\S.*?)\s+(0x\w+)\s+(.*)\s*$/is", $line, $lineMatches);
+      if (is_array($lineMatches) && count($lineMatches) >= 2) {
+        $stackFrame["number"] = $lineMatches[1];
+        $stackFrame["binary"] = $lineMatches[2];
+        $stackFrame["address"] = $lineMatches[3];
+        $stackFrame["description"] = $lineMatches[4];
+        $stackTrace[] = $stackFrame;
+      }
+    }
+  }
+
+  return $stackTrace;
+}
+
+function legacyCrashLogGroupArray($logdata) {
+  $reason = "";
+  $groupAddress = "";
+  $location = "";
+  $exceptionType = "";
+  $binaryies = "";
+  $jailbreak = 0;
+
+  // get the app path
+  $appPath = "";
+  preg_match('/^Path:\s*(.*?)$/mis', $logdata, $matches);
+  if (is_array($matches) && count($matches) >= 2) {
+    $appPath = $matches[1];
+
+    // remove app name
+    $appPath = substr($appPath, 0, strrpos($appPath, "/"));
+
+    // remove binary container (mac only)
+    if (substr($appPath, strlen($appPath)-4) != ".app") {
+      $appPath = substr($appPath, 0, strrpos($appPath, "/"));
+    }
+  }
+
+  // get the exception type
+  preg_match('/^Exception Type:\s*(.*?)$/mis', $logdata, $matches);
+  if (is_array($matches) && count($matches) >= 2) {
+    $exceptionType = $matches[1];
+  }
+
+  // find the apps binaries (including frameworks) and address ranges
+  $binaryImages = array();
+  preg_match('/Binary Images:.*?\n(.*?)\z/mis', $logdata, $matches);
+  if (is_array($matches) && count($matches) >= 2) {
+    $lines = explode("\n", $matches[1]);
+    foreach ($lines as $line) {
+      // we limit this to report version 104
+      $architectures = 'armv6|i386|x86_64|ppc|ppc64|armv4t|armv5|armv6|armv7|armv7s|arm64|arm-unknown';
+      preg_match('/^\s*(\w+)\s*-\s*(\w+)\s*(\+)?(.+)\s+('.$architectures.')\s+\<?([0-9A-Fa-f]{32})?>?\s*(.*)\s*$/i', $line, $binaryImageMatches);
+      if (is_array($binaryImageMatches) && count($binaryImageMatches) >= 2) {
+        $image["loadAddress"] = $binaryImageMatches[1];
+        $image["endAddress"] = $binaryImageMatches[2];
+        $image["binary"] = $binaryImageMatches[4];
+        $image["platform"] = $binaryImageMatches[5];
+        $image["uuid"] = $binaryImageMatches[6];
+        $image["path"] = $binaryImageMatches[7];
+
+        if (strpos($image["path"], "MobileSubstrate") !== false ||
+          strpos($image["path"], "CydiaSubstrate") !== false ||
+          strpos($image["binary"], "MobileSubstrate") !== false ||
+          strpos($image["binary"], "CydiaSubstrate") !== false)
+        {
+          $jailbreak = 1;
+        }
+
+        if (($appPath != "" && strpos($image["path"], $appPath) !== false) || (count($binaryImages) == 0))  {
+          if (count($binaryImages) == 0) {
+            // this is the actual app binary
+            $image["type"] = 0;
+          } else {
+            // this is an app bundled framework
+            $image["type"] = 1;
+          }
+        } else {
+          $image["type"] = 2;
+        }
+        $binaryImages[] = $image;
+      }
+    }
+  }
+
+  // get the exception reason
+  preg_match('/Application Specific Information:.*?\n(.*?)\n\n/mis', $logdata, $matches);
+  if (is_array($matches) && count($matches) >= 2) {
+    $reason = utf8_urldecode($matches[1]);
+    $reason = str_replace("*** Terminating app due to uncaught exception ", "", $reason);
+    $tempReason = str_replace("\n", "", $reason);
+    preg_match('/^(objc\[[^\]]*\]\: garbage collection is OFF)$/mis', $tempReason, $matches);
+    if (is_array($matches) && count($matches) >= 2) {
+      $reason = "No reason found";
+    }
+    $reason = trim($reason);
+  }
+
+  // get the crashing strack trace
+  $stackTrace = legacyParseThread('/Application Specific Backtrace:.*?\n(.*?)\n\n/mis', $logdata);
+  if (count($stackTrace) == 0) {
+    $stackTrace = legacyParseThread('/Last Exception Backtrace:.*?\n(.*?)\n\n/mis', $logdata);
+  }
+  if (count($stackTrace) == 0) {
+    $stackTrace = legacyParseThread('/Thread [0-9]+ Crashed:.*?\n(.*?)\n\n/mis', $logdata);
+  }
+  if (count($stackTrace) == 0) {
+    $stackTrace = legacyParseThread('/Thread [0-9]+ Crashed:\n(.*?)\n\n/mis', $logdata);
+  }
+
+  if (count($stackTrace) > 0) {
+    $binariesArray = array();
+    // if we have a stack trace, analyze it
+    foreach ($stackTrace as $stackFrame) {
+      $binariesArray[] = $stackFrame["binary"];
+
+      $description = $stackFrame["description"];
+      // if the stack trace contains a string from PLCrashReporter, then this is not the crash reason, so ignore it
+      if (strpos($description, "PLCrash") === false && strpos($description, "uncaught_exception_handler") === false) {
+
+        $stackFrameBinary = $stackFrame["binary"];
+        if (substr($stackFrameBinary, strlen($stackFrameBinary) - 3) == "...") {
+          $stackFrameBinary = substr($stackFrameBinary, strlen($stackFrameBinary) - 3);
+        }
+
+        // get the matching binary image
+        $binaryImage = array();
+        foreach ($binaryImages as $aBinaryImage) {
+          if (substr($aBinaryImage["binary"], 0, strlen($stackFrameBinary)) == $stackFrameBinary) {
+            // we only care about app specific frames, incl. the frameworks the app provides
+            if ($aBinaryImage["type"] < 2) {
+              $binaryImage = $aBinaryImage;
+              break;
+            }
+          }
+        }
+
+        if (count($binaryImage) > 0) {
+          $location = $description;
+          // we use the normalized address for grouping
+          if ($stackFrame["address"] > $binaryImage["loadAddress"]) {
+            $groupAddress = dechex(hexdec($stackFrame["address"]) - hexdec($binaryImage["loadAddress"]));
+          } else {
+            $groupAddress = $stackFrame["address"];
+          }
+          // we only care about the top most entry
+          break;
+        }
+      }
+    }
+    $binariesArray = array_unique($binariesArray);
+    sort($binariesArray, SORT_STRING | SORT_FLAG_CASE);
+    $binaries = implode(",", $binariesArray);
+  } else {
+    // no crashing thread? weird. we simply group by reason only then
+
+  }
+
+  if (strlen($reason) > 0) {
+    $resultArray["reason"] = $reason;
+  } else {
+    if (strlen($binaries) > 0) {
+      $resultArray["reason"] = "No Reason found. Full stack trace includes ".$binaries.".";
+    } else {
+
+    }
+  }
+  $resultArray["groupAddress"] = $groupAddress;
+  $resultArray["location"] = $location;
+  $resultArray["exceptionType"] = $exceptionType;
+  $resultArray["jailbreak"] = $jailbreak;
+
+  return $resultArray;
+}
+
+$options = getopt('', array('logs:', 'iterations:', 'rules:'));
+$count = isset($options['logs']) ? max(1, intval($options['logs'])) : 20;
+$iterations = isset($options['iterations']) ? max(1, intval($options['iterations'])) : 10;
+$ruleCount = isset($options['rules']) ? max(1, intval($options['rules'])) : 50;
+
+$corpus = array();
+$shape = array('threads' => 24, 'frames' => 32, 'images' => 300, 'groups' => $count);
+for ($i = 0; $i < $count; $i++) {
+  $log = benchCrashLog($shape, $i);
+  $corpus['synthetic '.$i] = $log;
+  $corpus['synthetic '.$i.' crlf'] = str_replace("\n", "\r\n", $log);
+  $corpus['synthetic '.$i.' truncated'] = substr($log, 0, (int)(strlen($log) / 2));
+}
+foreach ($argv as $index => $file) {
+  if ($index == 0 || substr($file, 0, 2) == '--') continue;
+  if (($log = @file_get_contents($file)) === false) die("Could not read ".$file."\n");
+  $corpus[$file] = $log;
+}
+
+$parsers = array('legacyCrashLogGroupArray' => 'regular expressions', 'crashLogGroupArrayPHP' => 'section scan');
+if (function_exists('quincy_parse_crash')) $parsers['quincy_parse_crash'] = 'extension';
+
+$mismatches = 0;
+foreach ($corpus as $name => $log) {
+  $result = crashLogGroupArrayPHP($log);
+  if (function_exists('quincy_parse_crash') && quincy_parse_crash($log) !== $result) {
+    echo "Different result of the extension for ".$name."\n";
+    $mismatches++;
+  }
+
+  // the regular expression parser didn't return the frames and images
+  unset($result['frames'], $result['images']);
+  if ($result !== legacyCrashLogGroupArray($log)) {
+    echo "Different result for ".$name."\n";
+    $mismatches++;
+  }
+}
+
+$bytes = 0;
+foreach ($corpus as $log) $bytes += strlen($log);
+printf("%d logs, %d bytes on average, %d different results\n", count($corpus), $bytes / count($corpus), $mismatches);
+
+foreach ($parsers as $function => $title) {
+  $start = microtime(true);
+  for ($i = 0; $i < $iterations; $i++) {
+    foreach ($corpus as $log) $function($log);
+  }
+  $duration = microtime(true) - $start;
+  printf("%-20s %8.3f ms per log, %6.1f MB/s\n", $title, $duration * 1000 / ($iterations * count($corpus)), $bytes * $iterations / $duration / 1048576);
+}
+
+// rules of every type, none of them matches a frame of the corpus
+$rules = array();
+for ($i = 0; $i < $ruleCount; $i++) {
+  $rules[] = array(FRAME_RULE_SKIP_SYMBOL, '-[QuincyAssertion'.$i.' ');
+  if ($i % 10 == 0) $rules[] = array(FRAME_RULE_SKIP_IMAGE, 'AssertionKit'.$i);
+  if ($i % 10 == 5) $rules[] = array(FRAME_RULE_SYSTEM_IMAGE, 'VendorKit'.$i);
+}
+$filter = compileFrameFilter($rules);
+
+foreach ($corpus as $name => $log) {
+  if (crashLogGroupArray($log, $filter) !== crashLogGroupArray($log)) {
+    echo "Different result with frame rules for ".$name."\n";
+    $mismatches++;
+  }
+}
+
+$durations = array();
+foreach (array('no frame rules' => null, count($rules).' frame rules' => $filter) as $title => $rulesFilter) {
+  $start = microtime(true);
+  for ($i = 0; $i < $iterations; $i++) {
+    foreach ($corpus as $log) crashLogGroupArray($log, $rulesFilter);
+  }
+  $durations[$title] = microtime(true) - $start;
+  printf("%-20s %8.3f ms per log\n", $title, $durations[$title] * 1000 / ($iterations * count($corpus)));
+}
+$values = array_values($durations);
+printf("frame rules cost %+.1f%%\n", ($values[1] - $values[0]) / $values[0] * 100);
+
+exit($mismatches > 0 ? 1 : 0);
+
+?>
@@ -0,0 +1,199 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Check the query plans of the admin UI, regrouping and ingest
+//
+// Runs EXPLAIN on the queries of these parts against the database configured in
+// config.php and fails if one of them reads all rows or the whole index of a
+// table that grows with the crashes, or if a query reading crashes in chunks has
+// to sort them, which reads all rows left for every chunk. Seed the database first, the optimizer
+// prefers a scan on small tables:
+//
+//   php admin_lists.php --populate=100000
+//   php explain_queries.php
+//
+// The queries are written like the code issues them, with the latest version
+// of the app, its biggest group and its latest crash as values. Searches with
+// LIKE '%text%' are left out, they read all crashes of the app by design, and
+// so is cli/regroup_history.php, which reads all crashes once.
+//
+// --bundleidentifier  the app whose queries are checked, de.buzzworks.QuincyDemo by default
+// --verbose           print the plan of every query, not only of the failing ones
+//
+// Exits with 1 if a query scans or a chunk sorts, so it can run after a schema change.
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+
+$options = getopt('', array('bundleidentifier:', 'verbose'));
+$bundleidentifier = isset($options['bundleidentifier']) ? $options['bundleidentifier'] : 'de.buzzworks.QuincyDemo';
+$verbose = isset($options['verbose']);
+
+if (!db_connect(false)) die("No database connection\n");
+
+// the tables that grow with the crashes, the others have a row per app, version or issue
+$checked = array($dbcrashtable, $dbbodytable, $dbframetable, $dbgrouptable, $dbsymbolicatetable, $dbrolluptable);
+
+function explainValue($query) {
+  $result = db_query($query);
+  if (!$result) die("Error in SQL ".$query."\n");
+  $row = db_fetch_row($result);
+  db_free_result($result);
+
+  return $row ? $row[0] : null;
+}
+
+$b = db_escape($bundleidentifier);
+$count = intval(explainValue("SELECT COUNT(*) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."'"));
+if ($count < 10000) die("Only ".$count." crashes of ".$bundleidentifier.", seed the database with php admin_lists.php --populate=100000\n");
+
+// the statistics decide the plans, they are not updated right after seeding
+foreach ($checked as $table) db_query("ANALYZE TABLE ".$table);
+
+$v = db_escape(explainValue("SELECT version FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' ORDER BY timestamp desc LIMIT 1"));
+$g = intval(explainValue("SELECT id FROM ".$dbgrouptable." WHERE bundleidentifier = '".$b."' AND affected = '".$v."' ORDER BY amount desc LIMIT 1"));
+$c = intval(explainValue("SELECT MAX(id) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."'"));
+$u = db_escape((string)explainValue("SELECT uuid FROM ".$dbcrashtable." WHERE id = ".$c));
+$i = intval(explainValue("SELECT MAX(issueid) FROM ".$dbgrouptable." WHERE bundleidentifier = '".$b."'"));
+
+$crashcolumns = "userid, username, contact, systemversion, timestamp, id, jailbreak, platform";
+$body = " JOIN ".$dbbodytable." ON ".$dbbodytable.".crashid = ".$dbcrashtable.".id";
+
+$queries = array(
+  // crashes.php
+  'crashes.php group list' => "SELECT ".$crashcolumns." FROM ".$dbcrashtable." WHERE groupid = ".$g." ORDER BY systemversion desc, timestamp desc",
+  'crashes.php group systemversions' => "SELECT systemversion, SUM(amount) FROM ".$dbrolluptable." WHERE groupid = ".$g." AND systemversion != '' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc",
+  'crashes.php group platforms' => "SELECT platform, SUM(amount) FROM ".$dbrolluptable." WHERE groupid = ".$g." AND platform != '' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc",
+  'crashes.php group count' => "SELECT IFNULL(SUM(amount), 0) FROM ".$dbrolluptable." WHERE groupid = ".$g,
+  'crashes.php ungrouped list' => "SELECT ".$crashcolumns." FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' AND version = '".$v."' AND groupid = 0 ORDER BY systemversion desc, timestamp desc",
+  'crashes.php ungrouped systemversions' => "SELECT systemversion, COUNT(systemversion) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' AND version = '".$v."' AND groupid = 0 group by systemversion order by systemversion desc",
+  'crashes.php search id' => "SELECT ".$crashcolumns." FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' AND id = '".$c."' AND version = '".$v."' ORDER BY systemversion desc, timestamp desc",
+  'crashes.php search symbol' => "SELECT ".$crashcolumns." FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' AND id IN (SELECT crashid FROM ".$dbframetable." WHERE symbol like 'objc_exception_throw%') ORDER BY systemversion desc, timestamp desc",
+  'crashes.php group' => "SELECT location, exception, reason, description FROM ".$dbgrouptable." WHERE id = '".$g."'",
+
+  // groups.php
+  'groups.php timestamps' => "SELECT DATE(hour), SUM(amount) FROM ".$dbrolluptable." WHERE bundleidentifier = '".$b."' AND version = '".$v."' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc",
+  'groups.php systemversions' => "SELECT systemversion, SUM(amount) FROM ".$dbrolluptable." WHERE bundleidentifier = '".$b."' AND version = '".$v."' AND systemversion != '' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc",
+  'groups.php platforms' => "SELECT platform, SUM(amount) FROM ".$dbrolluptable." WHERE bundleidentifier = '".$b."' AND version = '".$v."' AND platform != '' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc",
+  'groups.php group list' => "SELECT ".$dbgrouptable.".id, ".$dbgrouptable.".amount, ".$dbgrouptable.".latesttimestamp, ".$dbgrouptable.".location, ".$dbgrouptable.".exception, ".$dbgrouptable.".reason, ".$dbgrouptable.".description, ".
+    $dbgrouptable.".issueid, ".$dbissuetable.".amount, ".$dbissuetable.".groupcount FROM ".$dbgrouptable." LEFT JOIN ".$dbissuetable." ON ".$dbissuetable.".id = ".$dbgrouptable.".issueid ".
+    "WHERE ".$dbgrouptable.".bundleidentifier = '".$b."' AND ".$dbgrouptable.".affected = '".$v."' ORDER BY ".$dbgrouptable.".amount desc, ".$dbgrouptable.".location asc",
+  'groups.php ungrouped count' => "SELECT IFNULL(SUM(amount), 0) FROM ".$dbrolluptable." WHERE bundleidentifier = '".$b."' AND version = '".$v."' AND groupid = 0",
+
+  // app_versions.php and app_name.php
+  'app_versions.php timestamps' => "SELECT DATE(hour), SUM(amount) FROM ".$dbrolluptable." WHERE bundleidentifier = '".$b."' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc",
+  'app_versions.php systemversions' => "SELECT systemversion, SUM(amount) FROM ".$dbrolluptable." WHERE bundleidentifier = '".$b."' AND systemversion != '' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc",
+  'app_versions.php platforms' => "SELECT platform, SUM(amount) FROM ".$dbrolluptable." WHERE bundleidentifier = '".$b."' AND platform != '' GROUP BY 1 HAVING SUM(amount) > 0 ORDER BY 1 desc",
+  'app_versions.php group count' => "SELECT count(*) FROM ".$dbgrouptable." WHERE bundleidentifier = '".$b."' and affected = '".$v."'",
+  'app_versions.php crash count' => "SELECT IFNULL(SUM(amount), 0) FROM ".$dbrolluptable." WHERE bundleidentifier = '".$b."' AND version = '".$v."'",
+  'app_name.php crash count' => "SELECT IFNULL(SUM(amount), 0) FROM ".$dbrolluptable." WHERE bundleidentifier = '".$b."'",
+
+  // issues.php
+  'issues.php groups' => "SELECT id, affected, amount, latesttimestamp, location, exception, reason, description FROM ".$dbgrouptable." WHERE issueid = ".$i." AND bundleidentifier = '".$b."' ORDER BY INET_ATON(SUBSTRING_INDEX(CONCAT(affected, '.0.0.0'),  '.', 4)) desc",
+
+  // actionapi.php, crash_get.php, crash_update.php, download.php and symbolicate_todo.php
+  'actionapi.php group timestamp' => "SELECT max(UNIX_TIMESTAMP(timestamp)) FROM ".$dbcrashtable." WHERE groupid = '".$g."'",
+  'actionapi.php delete group chunk' => "SELECT id FROM ".$dbcrashtable." WHERE groupid = ".$g." LIMIT 1000",
+  'actionapi.php log' => "SELECT log, logcodec FROM ".$dbbodytable." WHERE crashid = ".$c,
+  'actionapi.php description' => "SELECT description FROM ".$dbbodytable." WHERE crashid = ".$c,
+  'download.php group' => "SELECT userid, contact, systemversion, description, log, timestamp, logcodec FROM ".$dbcrashtable.$body." WHERE ".$dbcrashtable.".groupid = '".$g."' ORDER BY systemversion desc, timestamp desc LIMIT 1",
+  'download.php crash' => "SELECT userid, contact, systemversion, description, log, timestamp, logcodec FROM ".$dbcrashtable.$body." WHERE ".$dbcrashtable.".id = '".$c."'",
+  'crash_update.php log' => "UPDATE ".$dbbodytable." SET log = '', logcodec = 0, logsize = 0 WHERE crashid = ".$c,
+  'crash_update.php app' => "SELECT bundleidentifier FROM ".$dbcrashtable." WHERE id = ".$c,
+  'crash_update.php frames' => "DELETE FROM ".$dbframetable." WHERE crashid = ".$c,
+  'symbolicate_todo.php todo' => "SELECT crashid FROM ".$dbsymbolicatetable." WHERE done = 0",
+
+  // deleteCrashes() and retention.inc
+  'delete crash todo' => "DELETE FROM ".$dbsymbolicatetable." WHERE crashid IN (".$c.")",
+  'delete crash frames' => "DELETE FROM ".$dbframetable." WHERE crashid IN (".$c.")",
+  'delete crash body' => "DELETE FROM ".$dbbodytable." WHERE crashid IN (".$c.")",
+  'delete crash rollup' => "UPDATE ".$dbrolluptable." JOIN (SELECT ".crashRollupColumns().", COUNT(*) AS amount FROM ".$dbcrashtable." WHERE id IN (".$c.") GROUP BY 1, 2, 3, 4, 5, 6) deleted ".
+    "USING (bundleidentifier, version, groupid, systemversion, platform, hour) SET ".$dbrolluptable.".amount = IF(".$dbrolluptable.".amount > deleted.amount, ".$dbrolluptable.".amount - deleted.amount, 0)",
+  'delete crash' => "DELETE FROM ".$dbcrashtable." WHERE id IN (".$c.")",
+  'expire chunk' => "SELECT id FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' AND version = '".$v."' AND timestamp < '".date('Y-m-01 00:00:00')."' LIMIT 1000",
+  'delete version chunk' => "SELECT id FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' AND version = '".$v."' AND id <= ".$c." LIMIT 1000",
+  'delete version groups' => "DELETE FROM ".$dbgrouptable." WHERE ".$dbgrouptable.".bundleidentifier = '".$b."' AND ".$dbgrouptable.".affected = '".$v."'".
+    " AND NOT EXISTS (SELECT 1 FROM ".$dbcrashtable." WHERE ".$dbcrashtable.".groupid = ".$dbgrouptable.".id)",
+
+  // regroup.inc and crashLogSearch()
+  'regroup count' => "SELECT COUNT(*) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' AND version = '".$v."' AND groupid = ".$g,
+  'regroup chunk' => "SELECT ".$dbcrashtable.".id, ".$dbbodytable.".log, ".$dbbodytable.".logcodec FROM ".$dbcrashtable.$body.
+    " WHERE ".$dbcrashtable.".bundleidentifier = '".$b."' AND ".$dbcrashtable.".version = '".$v."' AND ".$dbcrashtable.".groupid = ".$g." AND ".$dbcrashtable.".id > 0 ORDER BY ".$dbcrashtable.".id LIMIT 200",
+  'regroup version chunk' => "SELECT ".$dbcrashtable.".id, ".$dbbodytable.".log, ".$dbbodytable.".logcodec FROM ".$dbcrashtable.$body.
+    " WHERE ".$dbcrashtable.".bundleidentifier = '".$b."' AND ".$dbcrashtable.".version = '".$v."' AND ".$dbcrashtable.".id > 0 ORDER BY ".$dbcrashtable.".id LIMIT 200",
+  'regroup recount' => "UPDATE ".$dbgrouptable." LEFT JOIN (SELECT groupid, COUNT(*) AS amount, MAX(UNIX_TIMESTAMP(timestamp)) AS latesttimestamp FROM ".$dbcrashtable.
+    " WHERE 1 AND bundleidentifier = '".$b."' AND version = '".$v."' GROUP BY groupid) counted ON counted.groupid = ".$dbgrouptable.".id ".
+    "SET ".$dbgrouptable.".amount = IFNULL(counted.amount, 0), ".$dbgrouptable.".latesttimestamp = IFNULL(counted.latesttimestamp, 0) WHERE 1 AND ".$dbgrouptable.".bundleidentifier = '".$b."' AND ".$dbgrouptable.".affected = '".$v."'",
+  'regroup issue recount' => "SELECT issueid, COUNT(*) AS groupcount, SUM(amount) AS amount, MAX(latesttimestamp) AS latesttimestamp FROM ".$dbgrouptable." WHERE issueid > 0 AND 1 AND bundleidentifier = '".$b."' GROUP BY issueid",
+  'crash log search' => "SELECT ".$dbcrashtable.".id, ".$dbbodytable.".log, ".$dbbodytable.".logcodec FROM ".$dbcrashtable.$body." WHERE ".$dbcrashtable.".bundleidentifier = '".$b."' AND ".$dbcrashtable.".version = '".$v."'",
+
+  // submission handling in common.inc
+  'ingest known crash' => "SELECT id FROM ".$dbcrashtable." WHERE uuid = '".$u."'",
+  'ingest group amount' => "SELECT amount FROM ".$dbgrouptable." WHERE id = ".$g,
+  'ingest group update' => "UPDATE ".$dbgrouptable." SET amount=amount+1, latesttimestamp = 0 WHERE id = ".$g,
+  'ingest issue update' => "UPDATE ".$dbissuetable." JOIN ".$dbgrouptable." ON ".$dbissuetable.".id = ".$dbgrouptable.".issueid ".
+    "SET ".$dbissuetable.".amount = ".$dbissuetable.".amount + 1 WHERE ".$dbgrouptable.".id = ".$g,
+  'ingest regroup crashes' => "UPDATE ".$dbcrashtable." SET groupid=".$g." WHERE id in (".$c.", ".($c - 1).")",
+  'ingest link issue' => "SELECT ".$dbgrouptable.".id, ".$dbgrouptable.".bundleidentifier, ".$dbgrouptable.".amount, ".$dbgrouptable.".latesttimestamp FROM ".$dbgrouptable." ".
+    "JOIN ".$dbcrashtable." ON ".$dbcrashtable.".groupid = ".$dbgrouptable.".id WHERE ".$dbcrashtable.".id = ".$c." AND ".$dbgrouptable.".issueid = 0"
+);
+
+$failures = 0;
+foreach ($queries as $name => $query) {
+  $result = db_query("EXPLAIN ".$query);
+  if (!$result) die("Error in SQL EXPLAIN ".$query."\n");
+
+  $plan = array();
+  $scans = array();
+  $sorts = array();
+  while ($row = db_fetch_assoc($result)) {
+    $plan[] = sprintf("  %-14s %-8s %-16s %10s  %s", $row['table'], $row['type'], $row['key'] === null ? '-' : $row['key'], $row['rows'], $row['Extra']);
+    if (in_array($row['table'], $checked) && ($row['type'] == 'ALL' || $row['type'] == 'index')) $scans[] = $row['table'];
+    if (strpos($name, ' chunk') !== false && strpos($row['Extra'], 'Using filesort') !== false) $sorts[] = $row['table'];
+  }
+  db_free_result($result);
+
+  $status = "ok";
+  if (count($scans) > 0) $status = "SCAN of ".implode(", ", array_unique($scans));
+  else if (count($sorts) > 0) $status = "SORT of ".implode(", ", array_unique($sorts));
+
+  if ($status != "ok") $failures++;
+  printf("%-40s %s\n", $name, $status);
+  if ($verbose || $status != "ok") echo implode("\n", $plan)."\n";
+}
+
+echo "\n".count($queries)." queries, ".$failures." with a scan or sort\n";
+exit($failures > 0 ? 1 : 0);
+
+?>
@@ -0,0 +1,200 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Measure the ingest capacity of a server with synthetic crash reports
+//
+// Posts submissions to crash_v300.php at a given concurrency and reports
+// requests/s, crashes/s, the latency percentiles and the database statements
+// per crash. The statements are counted with the Questions status variable of
+// the database configured in config.php, so the server has to use the same
+// database and nothing else should run on it.
+//
+// Usage: php ingest_load.php --url=http://localhost/quincy/crash_v300.php [options]
+//        php ingest_load.php --compare=before.json after.json
+//
+// --requests     amount of submissions to send, 200 by default
+// --concurrency  submissions sent at the same time, 8 by default
+// --batch        crashes per submission, 5 by default
+// --threads, --frames, --images, --groups  shape of the crash logs, see crashgen.inc
+// --gzip         send gzip compressed XML bodies instead of the xmlstring field
+// --output       file the report is saved to as JSON
+// --compare      print the differences of two saved reports
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+require_once(dirname(__FILE__).'/crashgen.inc');
+
+$options = getopt('', array('url:', 'requests:', 'concurrency:', 'batch:', 'threads:', 'frames:', 'images:', 'groups:', 'gzip', 'output:', 'compare:'));
+
+function loadPercentile($values, $percentile) {
+  if (count($values) == 0) return 0;
+  sort($values);
+  return $values[min(count($values) - 1, (int)ceil($percentile / 100 * count($values)) - 1)];
+}
+
+function loadQuestions() {
+  if (!isset($GLOBALS['link'])) return null;
+
+  $result = db_query("SHOW GLOBAL STATUS LIKE 'Questions'");
+  if (!$result) return null;
+  $row = db_fetch_row($result);
+  db_free_result($result);
+
+  return intval($row[1]);
+}
+
+function loadCompare($before, $after) {
+  $metrics = array('requests_per_second', 'crashes_per_second', 'latency_p50_ms', 'latency_p99_ms', 'queries_per_crash', 'errors');
+  foreach ($metrics as $metric) {
+    $old = isset($before[$metric]) ? $before[$metric] : null;
+    $new = isset($after[$metric]) ? $after[$metric] : null;
+    $change = ($old !== null && $new !== null && $old != 0) ? sprintf("%+.1f%%", ($new - $old) / $old * 100) : "";
+    printf("%-22s %12s %12s %10s\n", $metric, $old === null ? "-" : $old, $new === null ? "-" : $new, $change);
+  }
+}
+
+if (isset($options['compare'])) {
+  $files = array($options['compare'], end($argv));
+  $reports = array();
+  foreach ($files as $file) {
+    $reports[] = json_decode(@file_get_contents($file), true);
+    if (!is_array(end($reports))) die("Could not read ".$file."\n");
+  }
+  loadCompare($reports[0], $reports[1]);
+  exit;
+}
+
+if (!isset($options['url'])) die("Usage: php ingest_load.php --url=http://host/path/crash_v300.php [--requests=N] [--concurrency=N] [--batch=N] [--gzip] [--output=file.json]\n");
+if (!function_exists('curl_multi_init')) die("The curl extension is required\n");
+
+$requests = isset($options['requests']) ? max(1, intval($options['requests'])) : 200;
+$concurrency = isset($options['concurrency']) ? max(1, intval($options['concurrency'])) : 8;
+$batch = isset($options['batch']) ? max(1, intval($options['batch'])) : 5;
+$gzip = isset($options['gzip']);
+
+// a new seed for every run, so the crashes are not dropped as already stored
+$shape = array('seed' => uniqid());
+foreach (array('threads', 'frames', 'images', 'groups') as $option) {
+  if (isset($options[$option])) $shape[$option] = max(1, intval($options[$option]));
+}
+$shape = benchCrashOptions($shape);
+
+if (!db_connect(false)) echo "No database connection, statements per crash are not counted\n";
+
+function loadRequest($url, $xml, $gzip) {
+  $handle = curl_init($url.(strpos($url, '?') === false ? '?' : '&').'ack=1');
+  curl_setopt($handle, CURLOPT_RETURNTRANSFER, true);
+  curl_setopt($handle, CURLOPT_POST, true);
+  curl_setopt($handle, CURLOPT_TIMEOUT, 120);
+  if ($gzip) {
+    curl_setopt($handle, CURLOPT_HTTPHEADER, array('Content-Type: text/xml', 'Content-Encoding: gzip'));
+    curl_setopt($handle, CURLOPT_POSTFIELDS, gzencode($xml));
+  } else {
+    curl_setopt($handle, CURLOPT_POSTFIELDS, array('xmlstring' => $xml));
+  }
+  return $handle;
+}
+
+$multi = curl_multi_init();
+$running = 0;
+$latencies = array();
+$errors = 0;
+$acknowledged = 0;
+$sent = 0;
+
+$questions = loadQuestions();
+$start = microtime(true);
+
+while ($sent < $requests || $running > 0) {
+  while ($sent < $requests && $running < $concurrency) {
+    $handle = loadRequest($options['url'], benchSubmission($shape, $sent * $batch, $batch), $gzip);
+    curl_multi_add_handle($multi, $handle);
+    $running++;
+    $sent++;
+  }
+
+  curl_multi_exec($multi, $active);
+  if (curl_multi_select($multi, 0.1) == -1) usleep(1000);
+
+  while (($info = curl_multi_info_read($multi)) !== false) {
+    $handle = $info['handle'];
+    $response = curl_multi_getcontent($handle);
+    $status = curl_getinfo($handle, CURLINFO_HTTP_CODE);
+    $latencies[] = curl_getinfo($handle, CURLINFO_TOTAL_TIME) * 1000;
+
+    if ($info['result'] != CURLE_OK || $status != 200 || !preg_match('/<result[^>]*>(-?\d+)<\/result>/', $response, $matches) || $matches[1] < 0)
+      $errors++;
+    $acknowledged += substr_count($response, '<crash uuid=');
+
+    curl_multi_remove_handle($multi, $handle);
+    curl_close($handle);
+    $running--;
+  }
+}
+
+$duration = microtime(true) - $start;
+$crashes = $requests * $batch;
+
+// the status query itself is counted as well
+$queries = null;
+if ($questions !== null) $queries = loadQuestions() - $questions - 1;
+
+$report = array(
+  'date' => date('c'),
+  'url' => $options['url'],
+  'requests' => $requests,
+  'concurrency' => $concurrency,
+  'batch' => $batch,
+  'gzip' => $gzip,
+  'threads' => $shape['threads'],
+  'frames' => $shape['frames'],
+  'images' => $shape['images'],
+  'groups' => $shape['groups'],
+  'duration' => round($duration, 3),
+  'errors' => $errors,
+  'acknowledged_crashes' => $acknowledged,
+  'requests_per_second' => round($requests / $duration, 2),
+  'crashes_per_second' => round($crashes / $duration, 2),
+  'latency_p50_ms' => round(loadPercentile($latencies, 50), 1),
+  'latency_p99_ms' => round(loadPercentile($latencies, 99), 1),
+  'queries_per_crash' => ($queries === null) ? null : round($queries / $crashes, 2)
+);
+
+foreach ($report as $key => $value)
+  printf("%-22s %s\n", $key, is_bool($value) ? ($value ? 'yes' : 'no') : ($value === null ? '-' : $value));
+
+if (isset($options['output']))
+  file_put_contents($options['output'], json_encode($report, defined('JSON_PRETTY_PRINT') ? JSON_PRETTY_PRINT : 0)."\n");
+
+?>
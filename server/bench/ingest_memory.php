@@ -0,0 +1,95 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Compare the peak memory of parsing a submission with the legacy xmlstring
+// path and the streaming path
+//
+// Usage: php ingest_memory.php [amount of crashes per submission]
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/ingest.inc');
+require_once(dirname(__FILE__).'/crashgen.inc');
+
+function benchmarkLog($index) {
+  return benchCrashLog(array('threads' => 1, 'frames' => 40, 'images' => 300), $index);
+}
+
+if ($argc > 2) {
+  $file = $argv[2];
+  $count = 0;
+  $reader = new XMLReader();
+
+  if ($argv[1] == 'legacy') {
+    $xmlstring = file_get_contents($file);
+    $xmlstring = str_replace("<description><![CDATA[", "<description>", $xmlstring);
+    $xmlstring = str_replace("]]></description>", "</description>", $xmlstring);
+    $xmlstring = str_replace("<description>", "<description><![CDATA[", $xmlstring);
+    $xmlstring = str_replace("</description>", "]]></description>", $xmlstring);
+    $reader->XML($xmlstring);
+
+    // the legacy code collected all crashes before processing them
+    $crashes = array();
+    readCrashReports($reader, function($crash) use (&$crashes) { $crashes[] = $crash; return true; });
+    $count = count($crashes);
+  } else {
+    $reader->open(ingestStreamURI('text/xml', $file));
+    readCrashReports($reader, function($crash) use (&$count) { $count++; return true; });
+  }
+  $reader->close();
+
+  echo $count." ".memory_get_peak_usage()."\n";
+  exit;
+}
+
+$crashes = ($argc > 1) ? intval($argv[1]) : 50;
+$file = tempnam(sys_get_temp_dir(), 'quincy');
+
+$output = fopen($file, 'w');
+fwrite($output, '<?xml version="1.0" encoding="UTF-8"?><crashes>');
+for ($i = 0; $i < $crashes; $i++) {
+  fwrite($output, "<crash><applicationname>QuincyDemo</applicationname><bundleidentifier>de.buzzworks.QuincyDemo</bundleidentifier><systemversion>7.1</systemversion><platform>iPhone6,1</platform><senderversion>1.0</senderversion><version>1.0</version>");
+  fwrite($output, "<log><![CDATA[".benchmarkLog($i)."]]></log><userid></userid><username></username><contact></contact><description>Some description & more</description></crash>");
+}
+fwrite($output, '</crashes>');
+fclose($output);
+
+echo "Submission with ".$crashes." crashes, ".filesize($file)." bytes\n";
+foreach (array('legacy', 'streaming') as $mode) {
+  $result = explode(' ', trim(exec(escapeshellarg(PHP_BINARY).' '.escapeshellarg(__FILE__).' '.$mode.' '.escapeshellarg($file))));
+  printf("%-10s %4d crashes, peak memory %10d bytes\n", $mode, $result[0], $result[1]);
+}
+
+unlink($file);
+
+?>
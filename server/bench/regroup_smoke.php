@@ -0,0 +1,110 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Smoke test of regrouping on a seeded test database
+//
+// Runs the chunk reader of regroup.php and regroupHistory() of
+// cli/regroup_history.php on the newest crashes of an app and fails if either
+// returns an error or leaves a crash without its new group. Seed the database
+// first:
+//
+//   php admin_lists.php --populate=10000
+//   php regroup_smoke.php
+//
+// regroupHistory() only writes the shadow column, which is reset for the
+// crashes it regrouped afterwards, so the groups shown in the admin interface
+// don't change. Don't run it while cli/regroup_history.php is running.
+//
+// --bundleidentifier  the app whose crashes are regrouped, de.buzzworks.QuincyDemo by default
+// --crashes           amount of the newest crashes regrouped, 200 by default
+//
+// Exits with 1 on a failure, so it can run after a change of regroup.inc.
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+require_once(dirname(__FILE__).'/../admin/regroup.inc');
+
+$options = getopt('', array('bundleidentifier:', 'crashes:'));
+$bundleidentifier = isset($options['bundleidentifier']) ? $options['bundleidentifier'] : 'de.buzzworks.QuincyDemo';
+$crashes = isset($options['crashes']) ? max(1, intval($options['crashes'])) : 200;
+
+$link = db_connect(false);
+if (!$link) die("No database connection\n");
+
+function smokeRow($query) {
+  $result = db_query($query);
+  if (!$result) die("Error in SQL ".$query."\n");
+  $row = db_fetch_row($result);
+  db_free_result($result);
+
+  return $row;
+}
+
+$b = db_escape($bundleidentifier);
+$row = smokeRow("SELECT version, MAX(id) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' GROUP BY version ORDER BY MAX(id) desc LIMIT 1");
+if (!$row) die("No crashes of ".$bundleidentifier.", seed the database with php admin_lists.php --populate=10000\n");
+$version = $row[0];
+$last = intval($row[1]);
+
+$failures = 0;
+
+// the chunk reader of regroup.php and cli/regroup.php, it only reads
+$read = regroupReadChunk(array('lastid' => 0), $bundleidentifier, $version, REGROUP_ALL, 10);
+if (!is_array($read) || count($read) == 0) $failures++;
+printf("%-30s %s\n", "regroup chunk", is_array($read) ? count($read)." crashes read" : "FAILED with ".$read);
+
+// the newest crashes of the app that have no new group yet, regrouped into the shadow column
+$row = smokeRow("SELECT MIN(id), COUNT(*) FROM (SELECT id FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' AND regroupid IS NULL ORDER BY id desc LIMIT ".$crashes.") newest");
+$first = intval($row[0]);
+$count = intval($row[1]);
+
+$start = microtime(true);
+$error = regroupHistory($first, $last, $bundleidentifier, 50);
+$duration = microtime(true) - $start;
+
+$row = smokeRow("SELECT COUNT(*) FROM ".$dbcrashtable." WHERE bundleidentifier = '".$b."' AND id >= ".$first." AND id <= ".$last." AND regroupid IS NULL");
+$missing = intval($row[0]);
+if ($error != "" || $missing > 0) $failures++;
+printf("%-30s %s\n", "regroup history", $error != "" ? "FAILED with ".$error : ($missing > 0 ? "FAILED, ".$missing." crashes without a new group" : $count." crashes in ".round($duration, 2)."s"));
+
+// leave the groups of the admin interface as they were
+$query = "UPDATE ".$dbcrashtable." SET regroupid = NULL WHERE bundleidentifier = '".$b."' AND id >= ".$first." AND id <= ".$last;
+if (!db_query($query)) die("Error in SQL ".$query."\n");
+
+db_close();
+
+echo "\n".$failures." failures\n";
+exit($failures > 0 ? 1 : 0);
+
+?>
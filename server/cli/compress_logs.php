@@ -0,0 +1,99 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Compresses the crash logs stored before logs were compressed
+//
+// Usage: php compress_logs.php [options]
+//
+// --bundleidentifier  only the logs of this app, all apps by default
+// --chunk             logs compressed in one transaction, 200 by default
+// --pause             milliseconds to wait after each chunk, 100 by default,
+//                     so the database keeps serving new crashes
+// --report            only print the bytes saved for each app
+//
+// It can be stopped any time and continues with the logs that are left when it
+// is started again. The bytes saved for each app are printed at the end.
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+require_once(dirname(__FILE__).'/../admin/logstore.inc');
+
+$options = getopt('', array('bundleidentifier:', 'chunk:', 'pause:', 'report'));
+
+$bundleidentifier = isset($options['bundleidentifier']) ? $options['bundleidentifier'] : null;
+$chunk = isset($options['chunk']) ? max(1, intval($options['chunk'])) : COMPRESS_CHUNK;
+$pause = isset($options['pause']) ? max(0, intval($options['pause'])) : 100;
+
+$link = db_connect(false);
+if (!$link) die("No database connection\n");
+
+if (!isset($options['report'])) {
+  if (crashLogCodec() == LOG_CODEC_NONE) die("No codec available, check \$log_codec in config.php\n");
+
+  $start = microtime(true);
+  $lastid = 0;
+  $crashes = 0;
+  $plain = 0;
+  $stored = 0;
+
+  do {
+    $done = compressLogChunk($lastid, $bundleidentifier, $chunk);
+    if (!is_array($done)) die("Compressing failed with ".$done."\n");
+
+    $lastid = $done['lastid'];
+    $crashes += $done['crashes'];
+    $plain += $done['plain'];
+    $stored += $done['stored'];
+
+    if ($done['crashes'] > 0) {
+      printf("%d logs up to id %d, %.1f logs/s, %.1f MB saved\n", $crashes, $lastid, $crashes / max(0.001, microtime(true) - $start), ($plain - $stored) / 1048576);
+      if ($pause > 0) usleep($pause * 1000);
+    }
+  } while ($done['crashes'] > 0);
+
+  echo "Compressed ".$crashes." logs in ".round(microtime(true) - $start, 1)."s\n\n";
+}
+
+$report = compressLogReport($bundleidentifier);
+if (!is_array($report)) die("Report failed with ".$report."\n");
+
+printf("%-40s %10s %10s %12s %12s %12s %6s\n", "App", "Crashes", "Compressed", "Plain MB", "Stored MB", "Saved MB", "Saved");
+foreach ($report as $app => $row) {
+  $saved = $row[2] - $row[3];
+  printf("%-40s %10d %10d %12.1f %12.1f %12.1f %5.1f%%\n", $app, $row[0], $row[1], $row[2] / 1048576, $row[3] / 1048576, $saved / 1048576, $row[2] > 0 ? $saved / $row[2] * 100 : 0);
+}
+
+db_close();
+
+?>
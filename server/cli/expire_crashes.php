@@ -0,0 +1,139 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Expires old crashes and deletes the crashes of versions in the background,
+// run it daily, e.g. from cron
+//
+// Usage: php expire_crashes.php [options]
+//
+// --chunk   crashes deleted in one transaction, 1000 by default
+// --pause   milliseconds to wait after each chunk, 100 by default,
+//           so the database keeps serving new crashes
+// --report  only print the partitions, the retention of each app and the
+//           pending version deletions
+//
+// It creates the monthly partitions of the next months, drops the months all
+// apps let expire, deletes the remaining expired crashes version by version and
+// works through the versions deleted in the admin interface. It can be stopped
+// any time and continues where it stopped when it is started again.
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+require_once(dirname(__FILE__).'/../admin/regroup.inc');
+require_once(dirname(__FILE__).'/../admin/retention.inc');
+
+$options = getopt('', array('chunk:', 'pause:', 'report'));
+
+$chunk = isset($options['chunk']) ? max(1, intval($options['chunk'])) : EXPIRE_CHUNK;
+$pause = isset($options['pause']) ? max(0, intval($options['pause'])) : 100;
+
+$link = db_connect(false);
+if (!$link) die("No database connection\n");
+
+$versions = retentionVersions();
+if (!is_array($versions)) die("Reading the versions failed with ".$versions."\n");
+
+if (isset($options['report'])) {
+  foreach (array($dbbodytable, $dbframetable) as $table) {
+    $partitions = retentionPartitions($table);
+    if ($partitions === false) die("Reading the partitions failed\n");
+    echo $table.": ".(count($partitions) > 0 ? implode(", ", array_keys($partitions)) : "not partitioned")."\n";
+  }
+
+  echo "\n";
+  printf("%-40s %-15s %s\n", "App", "Version", "Retention");
+  foreach ($versions as $version)
+    printf("%-40s %-15s %s\n", $version['bundleidentifier'], $version['version'], $version['months'] > 0 ? $version['months']." months" : "forever");
+
+  $jobs = deleteVersionJobs();
+  if (!is_array($jobs)) die("Reading the deletions failed with ".$jobs."\n");
+  echo "\n".count($jobs)." versions to delete\n";
+  foreach ($jobs as $job)
+    printf("%-40s %-15s %d crashes deleted\n", $job['bundleidentifier'], $job['affected'], $job['deleted']);
+
+  db_close();
+  exit;
+}
+
+// partitions can't be changed by two runs at once
+$result = db_query("SELECT GET_LOCK('quincy_expire_crashes', 0)");
+$row = $result ? db_fetch_row($result) : null;
+if ($result) db_free_result($result);
+if (!$row || $row[0] != 1) die("Another expire_crashes.php is running\n");
+
+$start = microtime(true);
+$created = retentionAddPartitions();
+if (!is_array($created)) die("Creating the partitions failed with ".$created."\n");
+if (count($created) > 0) printf("Created %s in %.1fs\n", implode(", ", $created), microtime(true) - $start);
+
+$start = microtime(true);
+$dropped = retentionDropPartitions($versions);
+if (!is_array($dropped)) die("Dropping the partitions failed with ".$dropped."\n");
+if (count($dropped) > 0) printf("Dropped %s in %.1fs\n", implode(", ", $dropped), microtime(true) - $start);
+
+foreach ($versions as $version) {
+  $expired = 0;
+  do {
+    $crashids = retentionExpireChunk($version, $chunk);
+    if (!is_array($crashids)) die("Expiring ".$version['bundleidentifier']." ".$version['version']." failed with ".$crashids."\n");
+    $expired += count($crashids);
+    if (count($crashids) > 0 && $pause > 0) usleep($pause * 1000);
+  } while (count($crashids) > 0);
+
+  if ($expired == 0) continue;
+
+  // groups without crashes left are deleted, unless they have a description
+  $error = regroupRecount($version['bundleidentifier'], $version['version'], true);
+  if ($error != "") die("Counting the groups of ".$version['bundleidentifier']." ".$version['version']." failed with ".$error."\n");
+  printf("%-40s %-15s %d crashes expired\n", $version['bundleidentifier'], $version['version'], $expired);
+}
+
+$jobs = deleteVersionJobs();
+if (!is_array($jobs)) die("Reading the deletions failed with ".$jobs."\n");
+
+foreach ($jobs as $job) {
+  $start = microtime(true);
+  do {
+    $done = deleteVersionChunk($job, $chunk);
+    if (!is_array($done)) die("Deleting ".$job['bundleidentifier']." ".$job['affected']." failed with ".$done."\n");
+    $job['deleted'] += $done['deleted'];
+    if (!$done['done'] && $pause > 0) usleep($pause * 1000);
+  } while (!$done['done']);
+
+  printf("%-40s %-15s %d crashes deleted in %.1fs\n", $job['bundleidentifier'], $job['affected'], $job['deleted'], microtime(true) - $start);
+}
+
+db_close();
+
+?>
@@ -0,0 +1,145 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Adds the submissions accepted into the spool by crash_v300.php to the database
+//
+// Usage: php ingest_worker.php [--workers=N] [--once]
+//        php ingest_worker.php --status
+//
+// --workers  amount of worker processes (requires the pcntl extension), 1 by default
+// --once     process all waiting submissions and exit, e.g. when run by cron
+// --status   print the state of the spool, lag is the age of the oldest
+//            unprocessed submission in seconds
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+require_once(dirname(__FILE__).'/../admin/ingest.inc');
+require_once(dirname(__FILE__).'/../admin/submission.inc');
+require_once(dirname(__FILE__).'/../admin/spool.inc');
+
+$options = getopt('', array('workers:', 'once', 'status'));
+$workers = isset($options['workers']) ? max(1, intval($options['workers'])) : 1;
+$once = isset($options['once']);
+
+if (isset($options['status'])) {
+  $status = spoolStatus();
+  echo "waiting ".$status['new']." processing ".$status['work']." failed ".$status['failed']." lag ".$status['lag']."\n";
+  exit;
+}
+
+// the spool already keeps the load on the database even, so crashes are never rate limited here
+$ingest_rate_limit = 0;
+
+// the shared memory of a command line process is not the one of the web server, so the
+// admin pages could not invalidate it; the settings are read once for every submission
+$metadata_cache_ttl = 0;
+
+if (!spoolPrepare()) die("Spool directory ".$ingest_spool_dir." is not writable\n");
+
+function runWorker($once) {
+  global $link, $ingest_spool_timeout;
+
+  // every worker needs its own connection, it is kept open for the whole run anyway
+  $link = db_connect(false);
+  if (!$link) {
+    fwrite(STDERR, "No database connection\n");
+    return 1;
+  }
+
+  while (true) {
+    $file = spoolClaim();
+    if ($file === false) {
+      if ($once) break;
+
+      spoolRecover($ingest_spool_timeout);
+      sleep(1);
+      continue;
+    }
+
+    $reader = new XMLReader();
+    if (!@$reader->open(ingestStreamURI('text/xml', $file))) {
+      spoolRelease($file);
+      continue;
+    }
+
+    $result = processSubmission($reader, "", $fatal);
+
+    if ($fatal) {
+      // nothing has been stored, so it is tried again later
+      fwrite(STDERR, basename($file).": ".$result."\n");
+      spoolRelease($file);
+
+      if (!db_ping()) {
+        db_close();
+        return 1;
+      }
+    } else {
+      spoolComplete($file);
+    }
+  }
+
+  db_close();
+  return 0;
+}
+
+// pick up what workers that died left behind
+spoolRecover($ingest_spool_timeout);
+
+if ($workers == 1 || !function_exists('pcntl_fork')) exit(runWorker($once));
+
+function startWorker($once) {
+  $pid = pcntl_fork();
+  if ($pid == -1) die("Could not start a worker process\n");
+  if ($pid == 0) exit(runWorker($once));
+
+  return $pid;
+}
+
+$children = array();
+for ($i = 0; $i < $workers; $i++)
+  $children[startWorker($once)] = true;
+
+while (count($children) > 0) {
+  $pid = pcntl_wait($status);
+  if ($pid <= 0) break;
+  unset($children[$pid]);
+
+  // replace workers that stopped, e.g. because the database connection was lost
+  if (!$once) {
+    sleep(1);
+    $children[startWorker($once)] = true;
+  }
+}
+
+?>
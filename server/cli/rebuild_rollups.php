@@ -0,0 +1,111 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Counts the crashes of the rollup table again from the crash table
+//
+// Usage: php rebuild_rollups.php [options]
+//
+// --bundleidentifier  only the versions of this app, all apps by default
+// --version           only this version of the app
+// --check             only compare the rollup table with the crashes and print
+//                     the versions whose amounts differ, exits with 1 if any do
+//
+// New crashes are counted at ingest, regrouping and deleting crashes keep the
+// table up to date as well. Use it when crashes were changed in the database
+// directly, or if the counts of the admin interface look wrong. Every version is
+// counted again in its own transaction.
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+
+$options = getopt('', array('bundleidentifier:', 'version:', 'check'));
+if (isset($options['version']) && !isset($options['bundleidentifier']))
+  die("Usage: php rebuild_rollups.php [--bundleidentifier=<id> [--version=<version>]] [--check]\n");
+
+$link = db_connect(false);
+if (!$link) die("No database connection\n");
+
+$where = "1";
+if (isset($options['bundleidentifier'])) $where .= " AND bundleidentifier = '".db_escape($options['bundleidentifier'])."'";
+if (isset($options['version'])) $where .= " AND version = '".db_escape($options['version'])."'";
+
+// the versions with crashes, and those that only have rollups left
+$versions = array();
+foreach (array("SELECT bundleidentifier, version, COUNT(*) FROM ".$dbcrashtable." WHERE ".$where." GROUP BY bundleidentifier, version",
+  "SELECT bundleidentifier, version, SUM(amount) FROM ".$dbrolluptable." WHERE ".$where." GROUP BY bundleidentifier, version") as $index => $query) {
+  $result = db_query($query);
+  if (!$result) die("Error in SQL ".$query."\n");
+  while ($row = db_fetch_row($result)) {
+    $key = $row[0]."|".$row[1];
+    if (!isset($versions[$key])) $versions[$key] = array('bundleidentifier' => (string)$row[0], 'version' => (string)$row[1], 'crashes' => 0, 'rollup' => 0);
+    $versions[$key][$index == 0 ? 'crashes' : 'rollup'] = intval($row[2]);
+  }
+  db_free_result($result);
+}
+
+if (isset($options['check'])) {
+  $differ = 0;
+  foreach ($versions as $version) {
+    if ($version['crashes'] == $version['rollup']) continue;
+    printf("%-40s %-15s %d crashes, %d in the rollup table\n", $version['bundleidentifier'], $version['version'], $version['crashes'], $version['rollup']);
+    $differ++;
+  }
+  echo $differ." of ".count($versions)." versions differ\n";
+
+  db_close();
+  exit($differ > 0 ? 1 : 0);
+}
+
+$start = microtime(true);
+foreach ($versions as $version) {
+  $bundleidentifier = $version['bundleidentifier'];
+  $versionstring = $version['version'];
+
+  $versionstart = microtime(true);
+  if (!db_query("START TRANSACTION")) die("No database connection\n");
+  $error = crashRollupRebuild($bundleidentifier, $versionstring);
+  if ($error == "" && !db_query("COMMIT")) $error = FAILURE_DATABASE_NOT_AVAILABLE;
+  if ($error != "") {
+    db_query("ROLLBACK");
+    die("Counting ".$bundleidentifier." ".$versionstring." failed with ".$error."\n");
+  }
+
+  printf("%-40s %-15s %d crashes in %.1fs\n", $bundleidentifier, $versionstring, $version['crashes'], microtime(true) - $versionstart);
+}
+
+db_close();
+
+echo "Counted ".count($versions)." versions in ".round(microtime(true) - $start, 1)."s\n";
+
+?>
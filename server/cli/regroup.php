@@ -0,0 +1,77 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Regroups the crashes of a version
+//
+// Usage: php regroup.php --bundleidentifier=<id> --version=<version> [options]
+//
+// --groupid  the group whose crashes are regrouped, 0 for the ungrouped ones,
+//            all crashes of the version by default
+// --chunk    crashes grouped in one transaction, 500 by default
+//
+// A regroup that was interrupted, here or in the admin interface, continues
+// after the last chunk that was done.
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+require_once(dirname(__FILE__).'/../admin/regroup.inc');
+
+$options = getopt('', array('bundleidentifier:', 'version:', 'groupid:', 'chunk:'));
+if (!isset($options['bundleidentifier']) || !isset($options['version']))
+  die("Usage: php regroup.php --bundleidentifier=<id> --version=<version> [--groupid=N] [--chunk=N]\n");
+
+$groupid = isset($options['groupid']) ? intval($options['groupid']) : REGROUP_ALL;
+$chunk = isset($options['chunk']) ? max(1, intval($options['chunk'])) : REGROUP_CHUNK;
+
+$link = db_connect(false);
+if (!$link) die("No database connection\n");
+
+$start = microtime(true);
+
+$job = regroupVersion($options['bundleidentifier'], $options['version'], $groupid, 0, $chunk, function($job) use ($start) {
+  if (!empty($job['done'])) return;
+
+  // a resumed job counts the crashes of earlier runs as well
+  $rate = ($job['processed'] - $job['resumed']) / max(0.001, microtime(true) - $start);
+  $eta = ($rate > 0) ? max(0, $job['total'] - $job['processed']) / $rate : 0;
+  printf("%d of %d crashes, %.1f crashes/s, eta %ds\n", $job['processed'], $job['total'], $rate, $eta);
+});
+
+db_close();
+
+if (!is_array($job)) die("Regroup failed with ".$job."\n");
+
+echo "Regrouped ".$job['processed']." crashes in ".round(microtime(true) - $start, 1)."s\n";
+
+?>
@@ -0,0 +1,148 @@
+<?php
+
+	/*
+	 * Author: Andreas Linde <mail@andreaslinde.de>
+	 *
+	 * Copyright (c) 2009-2014 Andreas Linde.
+	 * All rights reserved.
+	 *
+	 * Permission is hereby granted, free of charge, to any person
+	 * obtaining a copy of this software and associated documentation
+	 * files (the "Software"), to deal in the Software without
+	 * restriction, including without limitation the rights to use,
+	 * copy, modify, merge, publish, distribute, sublicense, and/or sell
+	 * copies of the Software, and to permit persons to whom the
+	 * Software is furnished to do so, subject to the following
+	 * conditions:
+	 *
+	 * The above copyright notice and this permission notice shall be
+	 * included in all copies or substantial portions of the Software.
+	 *
+	 * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	 * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	 * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	 * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	 * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	 * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	 * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	 * OTHER DEALINGS IN THE SOFTWARE.
+	 */
+
+//
+// Regroups all crashes with several worker processes, e.g. after the grouping
+// rules changed
+//
+// Usage: php regroup_history.php [--bundleidentifier=<id>] [--workers=N] [options]
+//
+// --bundleidentifier  only regroup the crashes of this app
+// --workers           amount of worker processes (requires the pcntl extension),
+//                     each one regroups a range of crash ids, 1 by default
+// --chunk             crashes grouped in one transaction, 500 by default
+// --no-swap           only write the new groups into the shadow column
+// --swap              only move the shadow column into place, e.g. after --no-swap
+// --prune             delete groups without crashes left and without a description
+//
+// The new group of each crash is written to crash.regroupid first, the admin
+// interface keeps showing the old groups. Once all workers are done the new
+// groups replace the old ones in one transaction. An interrupted run continues
+// with the crashes not done yet when it is started again.
+//
+
+if (php_sapi_name() != 'cli') die('Command line only');
+
+require_once(dirname(__FILE__).'/../config.php');
+require_once(dirname(__FILE__).'/../admin/common.inc');
+require_once(dirname(__FILE__).'/../admin/regroup.inc');
+
+$options = getopt('', array('bundleidentifier:', 'workers:', 'chunk:', 'no-swap', 'swap', 'prune'));
+$bundleidentifier = isset($options['bundleidentifier']) ? $options['bundleidentifier'] : null;
+$workers = isset($options['workers']) ? max(1, intval($options['workers'])) : 1;
+$chunk = isset($options['chunk']) ? max(1, intval($options['chunk'])) : REGROUP_CHUNK;
+if (!function_exists('pcntl_fork')) $workers = 1;
+
+function swapHistory($bundleidentifier, $prune) {
+  if (!db_connect(false)) die("No database connection\n");
+
+  $start = microtime(true);
+  $error = regroupSwap($bundleidentifier, $prune);
+  db_close();
+  if ($error != "") die("Swapping the new groups failed with ".$error."\n");
+
+  printf("Swapped the new groups in %.1fs\n", microtime(true) - $start);
+}
+
+function runWorker($worker, $first, $last, $bundleidentifier, $chunk) {
+  // every worker needs its own connection
+  if (!db_connect(false)) {
+    fwrite(STDERR, "worker ".$worker.": no database connection\n");
+    return 1;
+  }
+
+  $start = microtime(true);
+  $reported = $start;
+  $error = regroupHistory($first, $last, $bundleidentifier, $chunk, function($processed, $lastid) use ($worker, $first, $last, $start, &$reported) {
+    $now = microtime(true);
+    if ($now - $reported < 5 && $lastid < $last) return;
+    $reported = $now;
+
+    // the crashes are spread evenly enough over the ids to estimate the time left from them
+    $done = ($lastid - $first + 1) / ($last - $first + 1);
+    $eta = ($done > 0) ? ($now - $start) * (1 - $done) / $done : 0;
+    printf("worker %d: %d crashes, %.1f crashes/s, %.1f%%, eta %ds\n", $worker, $processed, $processed / max(0.001, $now - $start), $done * 100, $eta);
+  });
+  db_close();
+
+  if ($error != "") {
+    fwrite(STDERR, "worker ".$worker.": failed with ".$error."\n");
+    return 1;
+  }
+  printf("worker %d: done in %.1fs\n", $worker, microtime(true) - $start);
+  return 0;
+}
+
+if (isset($options['swap'])) {
+  swapHistory($bundleidentifier, isset($options['prune']));
+  exit;
+}
+
+if (!db_connect(false)) die("No database connection\n");
+$range = regroupHistoryRange($bundleidentifier);
+db_close();
+if ($range === false) die("Could not read the crashes to regroup\n");
+
+if ($range[0] !== null) {
+  // every worker gets the same share of the id space
+  $size = (int)ceil(($range[1] - $range[0] + 1) / $workers);
+
+  $start = microtime(true);
+  $failed = 0;
+
+  if ($workers == 1) {
+    $failed = runWorker(1, $range[0], $range[1], $bundleidentifier, $chunk);
+  } else {
+    $children = array();
+    for ($i = 0; $i < $workers; $i++) {
+      $first = $range[0] + $i * $size;
+      if ($first > $range[1]) break;
+
+      $pid = pcntl_fork();
+      if ($pid == -1) die("Could not start a worker process\n");
+      if ($pid == 0) exit(runWorker($i + 1, $first, min($range[1], $first + $size - 1), $bundleidentifier, $chunk));
+      $children[$pid] = true;
+    }
+
+    while (count($children) > 0) {
+      $pid = pcntl_wait($status);
+      if ($pid <= 0) break;
+      unset($children[$pid]);
+      if (!pcntl_wifexited($status) || pcntl_wexitstatus($status) != 0) $failed++;
+    }
+  }
+
+  printf("Regrouped in %.1fs\n", microtime(true) - $start);
+  if ($failed > 0) die("Not all workers finished, start again to continue\n");
+}
+
+if (!isset($options['no-swap'])) swapHistory($bundleidentifier, isset($options['prune']));
+
+?>
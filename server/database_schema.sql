@@ -29,6 +29,7 @@ SET FOREIGN_KEY_CHECKS = 0;
 -- contains a list of all applications that are accepted
 -- bundleidentifier: the bundle identifier of the application allowed to provide crash reports
 -- symbolicate: if the todo table should be filled to remotely symbolicate crash reports for this applciation
+-- retention: the months crashes are kept, 0 keeps them forever, NULL uses $crash_retention in config.php
 CREATE TABLE IF NOT EXISTS `apps` (
   `id` bigint(20) unsigned NOT NULL auto_increment,
   `bundleidentifier` varchar(250) NOT NULL,
@@ -38,6 +39,7 @@ CREATE TABLE IF NOT EXISTS `apps` (
   `notifyemail` text default NULL,
   `notifypush` text default NULL,
   `hockeyappidentifier` text default NULL,
+  `retention` smallint(5) unsigned default NULL,
   PRIMARY KEY  (`id`),
   KEY `bundleIdentifier` (`bundleidentifier`)
 ) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
@@ -48,7 +50,7 @@ CREATE TABLE IF NOT EXISTS `apps` (
 -- Table structure for table `crash`
 --
 
--- contains all crash log data
+-- contains the metadata of all crashes, the crash log and description are in `crash_body`
 -- userid: if there was some kind of user/device identification provided in the crash log, this contains the string provided
 -- username: if there was some kind of user name provided, this contains the string provided
 -- contact: if there was some kind of contact information provided, this contains the string
@@ -56,10 +58,12 @@ CREATE TABLE IF NOT EXISTS `apps` (
 -- bundleidentifier: the bundle identifier of the application this crash report is associated with
 -- serverversion: the version of the app that sent this report
 -- version: the version of the app that crashed
--- description: if there was some description text provided, this contains the string
--- log: the actual crash log data
 -- timestamp: the timestamp the crash log data was added to the database
 -- groupid: the crash group this crash was associated with
+-- uuid: the incident identifier of the crash report, so a crash sent again is only stored once
+-- regroupid: the new crash group while all crashes are regrouped by cli/regroup_history.php, NULL otherwise
+-- the keys cover the crash lists of the admin UI: the crashes of a group by system version and time, the crashes of an app and version by time,
+-- the crashes of an app and version by group, and their amounts per system version and per platform
 CREATE TABLE IF NOT EXISTS `crash` (
   `id` bigint(20) unsigned NOT NULL auto_increment,
   `userid` varchar(255) collate utf8_unicode_ci default NULL,
@@ -71,19 +75,80 @@ CREATE TABLE IF NOT EXISTS `crash` (
   `applicationname` varchar(50) collate utf8_unicode_ci default NULL,
   `senderversion` varchar(15) collate utf8_unicode_ci NOT NULL default '',
   `version` varchar(15) collate utf8_unicode_ci default NULL,
-  `description` mediumtext collate utf8_unicode_ci,
-  `log` text collate utf8_unicode_ci NOT NULL,
   `timestamp` timestamp NOT NULL default CURRENT_TIMESTAMP,
   `groupid` bigint(20) unsigned default '0',
   `jailbreak` int(11) unsigned default '0',
+  `uuid` varchar(36) collate utf8_unicode_ci default NULL,
+  `regroupid` bigint(20) unsigned default NULL,
   PRIMARY KEY  (`id`),
-  KEY `groupid` (`groupid`),
-  KEY `bundleidentifier` (`bundleidentifier`),
+  UNIQUE KEY `uuid` (`uuid`),
+  KEY `groupid` (`groupid`, `systemversion`, `timestamp`),
+  KEY `bundleidentifier` (`bundleidentifier`, `version`, `timestamp`),
+  KEY `versiongroup` (`bundleidentifier`, `version`, `groupid`, `systemversion`, `timestamp`),
+  KEY `systemversion` (`bundleidentifier`, `version`, `systemversion`),
+  KEY `platform` (`bundleidentifier`, `version`, `platform`),
+  KEY `versionchunk` (`bundleidentifier`, `version`, `id`),
+  KEY `groupchunk` (`bundleidentifier`, `version`, `groupid`, `id`),
   CONSTRAINT `FK_CRASH_GROUPID` FOREIGN KEY (`groupid`) REFERENCES `crash_groups` (`id`) ON DELETE CASCADE
 ) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
 
 -- --------------------------------------------------------
 
+--
+-- Table structure for table `crash_body`
+--
+
+-- contains the crash log and description of each crash, read only when a single crash is shown, downloaded, regrouped or symbolicated
+-- crashid: the crash in `crash`
+-- month: the month the crash was stored as YYYYMM, the table is partitioned by it, see cli/expire_crashes.php
+-- description: if there was some description text provided, this contains the string
+-- log: the actual crash log data, compressed with the codec in logcodec
+-- logcodec: how the log is compressed, see LOG_CODEC_* in config.php for values
+-- logsize: the size of the uncompressed log, 0 for logs stored before compression until cli/compress_logs.php compressed them
+CREATE TABLE IF NOT EXISTS `crash_body` (
+  `crashid` bigint(20) unsigned NOT NULL,
+  `month` mediumint(8) unsigned NOT NULL default '0',
+  `description` mediumtext collate utf8_unicode_ci,
+  `log` mediumblob NOT NULL,
+  `logcodec` tinyint(3) unsigned NOT NULL default '0',
+  `logsize` int(10) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`crashid`, `month`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci
+PARTITION BY RANGE (`month`) (PARTITION pmax VALUES LESS THAN MAXVALUE);
+
+-- --------------------------------------------------------
+
+--
+-- Table structure for table `crash_frames`
+--
+
+-- contains the parsed stack frames of the crash logs, see $ingest_frames in config.php for which threads
+-- crashid: the crash the frame belongs to
+-- month: the month of the crash body, the table is partitioned by it like `crash_body`
+-- thread: the thread number, -1 for the backtrace of the uncaught exception
+-- crashed: 1 if the thread crashed or is the exception backtrace
+-- frame: the number of the frame in its thread
+-- image, imageuuid: the name and UUID of the binary image containing the address, imageuuid is NULL if no image was found
+-- offset: the address relative to the load address of the image, or the address itself if no image was found
+-- symbol: the symbol name without the offset, NULL if the frame is not symbolicated
+CREATE TABLE IF NOT EXISTS `crash_frames` (
+  `crashid` bigint(20) unsigned NOT NULL,
+  `month` mediumint(8) unsigned NOT NULL default '0',
+  `thread` smallint(6) NOT NULL default '0',
+  `crashed` tinyint(3) unsigned NOT NULL default '0',
+  `frame` smallint(5) unsigned NOT NULL default '0',
+  `image` varchar(64) collate utf8_unicode_ci NOT NULL default '',
+  `imageuuid` binary(16) default NULL,
+  `offset` bigint(20) unsigned NOT NULL default '0',
+  `symbol` varchar(250) collate utf8_unicode_ci default NULL,
+  PRIMARY KEY  (`crashid`, `thread`, `frame`, `month`),
+  KEY `symbol` (`symbol`(191)),
+  KEY `image` (`imageuuid`, `offset`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci
+PARTITION BY RANGE (`month`) (PARTITION pmax VALUES LESS THAN MAXVALUE);
+
+-- --------------------------------------------------------
+
 --
 -- Table structure for table `crash_groups`
 --
@@ -93,13 +158,20 @@ CREATE TABLE IF NOT EXISTS `crash` (
 -- affected: the version of the application that has this crash
 -- fix: the version which will fix this crash
 -- pattern: the string to search for to detect if a crash belongs to this group
+-- fingerprint: the first 64 bits of the MD5 hash of the fingerprint text, unique per app, version and fingerprint version
+-- fingerprintversion: how the group was found, 1 by the pattern, 2 by the top app frames
+-- issueid: the issue in `crash_issues` this group belongs to, 0 if its crashes are not symbolicated
 -- description: an optional description text which can be added in the admin UI
 -- amoun: the amount crash logs associated with this crash group
+-- the amount key lists the groups of an app version ordered by their amount, the fingerprint key finds the group of a crash
 CREATE TABLE IF NOT EXISTS `crash_groups` (
   `id` bigint(20) unsigned NOT NULL auto_increment,
   `bundleidentifier` varchar(250) collate utf8_unicode_ci default NULL,
   `affected` varchar(20) collate utf8_unicode_ci default NULL,
   `pattern` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  `fingerprint` bigint(20) unsigned NOT NULL default '0',
+  `fingerprintversion` tinyint(3) unsigned NOT NULL default '1',
+  `issueid` bigint(20) unsigned NOT NULL default '0',
   `location` varchar(250) collate utf8_unicode_ci NOT NULL default '',
   `exception` varchar(250) collate utf8_unicode_ci NOT NULL default '',
   `reason` text collate utf8_unicode_ci,
@@ -107,7 +179,130 @@ CREATE TABLE IF NOT EXISTS `crash_groups` (
   `amount` bigint(20) default '0',
   `latesttimestamp` bigint(20) default '0',
   PRIMARY KEY  (`id`),
-  KEY `bundleIdentifier` (`bundleidentifier`)
+  UNIQUE KEY `fingerprint` (`bundleidentifier`(191), `affected`, `fingerprintversion`, `fingerprint`),
+  KEY `amount` (`bundleidentifier`, `affected`, `amount`),
+  KEY `issueid` (`issueid`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
+
+-- --------------------------------------------------------
+
+--
+-- Table structure for table `crash_issues`
+--
+
+-- contains the crash groups of all versions of an application that crash at the same symbols
+-- bundleidentifier: the bundle identifier that this issue is associated with
+-- fingerprint: the first 64 bits of the MD5 hash of the pattern, unique per app
+-- pattern: the symbol names of the top app stack frames
+-- groupcount: the amount of crash groups linked to this issue
+-- amount: the amount of crash logs of all linked crash groups
+CREATE TABLE IF NOT EXISTS `crash_issues` (
+  `id` bigint(20) unsigned NOT NULL auto_increment,
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci default NULL,
+  `fingerprint` bigint(20) unsigned NOT NULL default '0',
+  `pattern` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  `location` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  `exception` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  `reason` text collate utf8_unicode_ci,
+  `groupcount` int(11) NOT NULL default '0',
+  `amount` bigint(20) default '0',
+  `latesttimestamp` bigint(20) default '0',
+  PRIMARY KEY  (`id`),
+  UNIQUE KEY `fingerprint` (`bundleidentifier`(191), `fingerprint`),
+  KEY `amount` (`bundleidentifier`(191), `amount`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
+
+-- --------------------------------------------------------
+
+--
+-- Table structure for table `crash_rollup`
+--
+
+-- contains the amount of crashes per hour, kept up to date at ingest, so the charts and counts of the admin UI don't read the crashes
+-- bundleidentifier, version, groupid, systemversion, platform: those of the crashes, an empty string if the crash has none
+-- hour: the hour the crashes were stored in
+-- amount: the amount of crashes, cli/rebuild_rollups.php counts them again from `crash`
+-- the primary key covers the charts and counts of an app and a version, the groupid key those of a group
+CREATE TABLE IF NOT EXISTS `crash_rollup` (
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  `version` varchar(15) collate utf8_unicode_ci NOT NULL default '',
+  `groupid` bigint(20) unsigned NOT NULL default '0',
+  `systemversion` varchar(25) collate utf8_unicode_ci NOT NULL default '',
+  `platform` varchar(25) collate utf8_unicode_ci NOT NULL default '',
+  `hour` datetime NOT NULL,
+  `amount` int(10) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`bundleidentifier`, `version`, `groupid`, `systemversion`, `platform`, `hour`),
+  KEY `groupid` (`groupid`, `hour`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
+
+-- --------------------------------------------------------
+
+--
+-- Table structure for table `delete_jobs`
+--
+
+-- contains the versions whose crashes are deleted in the background by cli/expire_crashes.php
+-- bundleidentifier, affected: the version whose crashes are deleted
+-- lastid: the id of the newest crash to delete, crashes sent after the deletion was started are kept
+-- deleted: the amount of crashes deleted so far
+-- done: value of 1 once all crashes and the groups left without crashes are deleted
+CREATE TABLE IF NOT EXISTS `delete_jobs` (
+  `id` bigint(20) unsigned NOT NULL auto_increment,
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci default NULL,
+  `affected` varchar(20) collate utf8_unicode_ci default NULL,
+  `lastid` bigint(20) unsigned NOT NULL default '0',
+  `deleted` bigint(20) NOT NULL default '0',
+  `started` bigint(20) NOT NULL default '0',
+  `updated` bigint(20) NOT NULL default '0',
+  `done` tinyint(4) NOT NULL default '0',
+  PRIMARY KEY  (`id`),
+  KEY `done` (`done`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
+
+-- --------------------------------------------------------
+
+--
+-- Table structure for table `frame_rules`
+--
+
+-- contains the rules of an application which stack frames are skipped when its crashes are grouped
+-- bundleidentifier: the application this rule belongs to
+-- type: what the rule skips, see FRAME_RULE_* in config.php for values
+-- value: the binary image name or the symbol prefix
+CREATE TABLE IF NOT EXISTS `frame_rules` (
+  `id` bigint(20) unsigned NOT NULL auto_increment,
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci NOT NULL,
+  `type` tinyint(3) unsigned NOT NULL default '0',
+  `value` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  PRIMARY KEY  (`id`),
+  KEY `bundleidentifier` (`bundleidentifier`(191))
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
+
+-- --------------------------------------------------------
+
+--
+-- Table structure for table `regroup_jobs`
+--
+
+-- contains the progress of regrouping the crashes of a version
+-- bundleidentifier, affected: the version whose crashes are regrouped
+-- groupid: the group whose crashes are regrouped, 0 for the ungrouped ones and -1 for all crashes of the version
+-- lastid: the id of the last crash that has been regrouped, crashes are regrouped in the order of their id
+-- processed, total: the amount of crashes regrouped so far and the amount of crashes when the job was started
+-- done: value of 1 once all crashes are regrouped and the group amounts are counted
+CREATE TABLE IF NOT EXISTS `regroup_jobs` (
+  `id` bigint(20) unsigned NOT NULL auto_increment,
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci default NULL,
+  `affected` varchar(20) collate utf8_unicode_ci default NULL,
+  `groupid` bigint(20) NOT NULL default '0',
+  `lastid` bigint(20) unsigned NOT NULL default '0',
+  `processed` bigint(20) NOT NULL default '0',
+  `total` bigint(20) NOT NULL default '0',
+  `started` bigint(20) NOT NULL default '0',
+  `updated` bigint(20) NOT NULL default '0',
+  `done` tinyint(4) NOT NULL default '0',
+  PRIMARY KEY  (`id`),
+  UNIQUE KEY `job` (`bundleidentifier`(191), `affected`, `groupid`)
 ) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
 
 -- --------------------------------------------------------
@@ -0,0 +1,8 @@
+dnl config.m4 for the QuincyKit crash log parser
+
+PHP_ARG_ENABLE(quincy, whether to enable the QuincyKit crash log parser,
+[  --enable-quincy         Enable the QuincyKit crash log parser])
+
+if test "$PHP_QUINCY" != "no"; then
+  PHP_NEW_EXTENSION(quincy, quincy.c crashlog.c, $ext_shared)
+fi
@@ -0,0 +1,314 @@
+/*
+ * Author: Andreas Linde <mail@andreaslinde.de>
+ *
+ * Copyright (c) 2009-2014 Andreas Linde.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <strings.h>
+
+#include "crashlog.h"
+
+/* the architectures of binary images in the order the PHP expression tries them */
+static const char *quincy_architectures[] = {
+    "armv6", "i386", "x86_64", "ppc", "ppc64", "armv4t", "armv5", "armv6", "armv7", "armv7s", "arm64", "arm-unknown", NULL
+};
+
+/* \s of PCRE */
+static int quincy_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+/* \w of PCRE */
+static int quincy_word(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static int quincy_hex(char c)
+{
+    return (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || (c >= '0' && c <= '9');
+}
+
+static size_t quincy_skip_spaces(const char *data, size_t position, size_t end)
+{
+    while (position < end && quincy_space(data[position])) position++;
+    return position;
+}
+
+static size_t quincy_skip_words(const char *data, size_t position, size_t end)
+{
+    while (position < end && quincy_word(data[position])) position++;
+    return position;
+}
+
+/* does the line at offset start with the literal, like substr_compare() == 0 */
+static int quincy_starts(const char *data, size_t length, size_t offset, const char *literal, size_t literal_length)
+{
+    return offset + literal_length <= length && memcmp(data + offset, literal, literal_length) == 0;
+}
+
+#define QUINCY_STARTS(literal) quincy_starts(data, length, offset, literal, sizeof(literal) - 1)
+
+void quincy_scan_sections(const char *data, size_t length, quincy_sections *sections)
+{
+    size_t offset = 0;
+
+    sections->path = QUINCY_NOT_FOUND;
+    sections->exception_type = QUINCY_NOT_FOUND;
+    sections->information = QUINCY_NOT_FOUND;
+    sections->specific_backtrace = QUINCY_NOT_FOUND;
+    sections->last_exception_backtrace = QUINCY_NOT_FOUND;
+    sections->crashed_thread = QUINCY_NOT_FOUND;
+    sections->crashed_thread_exact = QUINCY_NOT_FOUND;
+    sections->binary_images = QUINCY_NOT_FOUND;
+
+    while (offset < length) {
+        const char *newline = memchr(data + offset, '\n', length - offset);
+        size_t end = newline ? (size_t)(newline - data) : length;
+        /* a section needs at least the line break of its header */
+        int has_next = end < length;
+        size_t next = end + 1;
+
+        switch (data[offset]) {
+            case 'P':
+                if (sections->path == QUINCY_NOT_FOUND && QUINCY_STARTS("Path:"))
+                    sections->path = offset + 5;
+                break;
+            case 'E':
+                if (sections->exception_type == QUINCY_NOT_FOUND && QUINCY_STARTS("Exception Type:"))
+                    sections->exception_type = offset + 15;
+                break;
+            case 'A':
+                if (!has_next) break;
+                if (sections->information == QUINCY_NOT_FOUND && QUINCY_STARTS("Application Specific Information:"))
+                    sections->information = next;
+                else if (sections->specific_backtrace == QUINCY_NOT_FOUND && QUINCY_STARTS("Application Specific Backtrace:"))
+                    sections->specific_backtrace = next;
+                break;
+            case 'L':
+                if (has_next && sections->last_exception_backtrace == QUINCY_NOT_FOUND && QUINCY_STARTS("Last Exception Backtrace:"))
+                    sections->last_exception_backtrace = next;
+                break;
+            case 'T': {
+                size_t header = offset + 7;
+                if (!has_next || !QUINCY_STARTS("Thread ")) break;
+                while (header < end && data[header] >= '0' && data[header] <= '9') header++;
+                if (header == offset + 7) break;
+                if (quincy_starts(data, length, header, " Crashed:", 9)) {
+                    if (sections->crashed_thread == QUINCY_NOT_FOUND)
+                        sections->crashed_thread = next;
+                    if (sections->crashed_thread_exact == QUINCY_NOT_FOUND && header + 9 == end)
+                        sections->crashed_thread_exact = next;
+                }
+                break;
+            }
+            case 'B':
+                if (QUINCY_STARTS("Binary Images:")) {
+                    if (has_next) sections->binary_images = next;
+                    /* nothing but binary images follows */
+                    return;
+                }
+                break;
+        }
+
+        offset = end + 1;
+    }
+}
+
+int quincy_field(const char *data, size_t length, size_t offset, quincy_span *value)
+{
+    const char *newline;
+    size_t start;
+
+    if (offset == QUINCY_NOT_FOUND) return 0;
+
+    start = quincy_skip_spaces(data, offset, length);
+    newline = memchr(data + start, '\n', length - start);
+    value->start = start;
+    value->length = (newline ? (size_t)(newline - data) : length) - start;
+
+    return 1;
+}
+
+int quincy_section(const char *data, size_t length, size_t offset, quincy_span *section)
+{
+    size_t position = offset;
+
+    if (offset == QUINCY_NOT_FOUND) return 0;
+
+    while (position + 1 < length) {
+        const char *newline = memchr(data + position, '\n', length - position - 1);
+        if (!newline) break;
+        position = newline - data;
+        if (data[position + 1] == '\n') {
+            section->start = offset;
+            section->length = position - offset;
+            return 1;
+        }
+        position++;
+    }
+
+    return 0;
+}
+
+/*
+ * /^(\d+)\s+(\S.*?)\s+(0x\w+)\s+(.*)\s*$/is
+ *
+ * The binary name ends with the first whitespace which is followed by an address
+ * and more whitespace, the description is the rest of the line.
+ */
+int quincy_match_frame(const char *data, size_t start, size_t end, quincy_frame *frame)
+{
+    size_t position = start;
+    size_t binary;
+
+    while (position < end && data[position] >= '0' && data[position] <= '9') position++;
+    if (position == start) return 0;
+    frame->number.start = start;
+    frame->number.length = position - start;
+
+    binary = quincy_skip_spaces(data, position, end);
+    if (binary == position || binary >= end) return 0;
+
+    position = binary + 1;
+    while (position < end) {
+        size_t address, words;
+
+        if (!quincy_space(data[position])) {
+            position++;
+            continue;
+        }
+
+        address = quincy_skip_spaces(data, position, end);
+        if (address + 2 < end && data[address] == '0' && (data[address + 1] == 'x' || data[address + 1] == 'X')) {
+            words = quincy_skip_words(data, address + 2, end);
+            if (words > address + 2 && words < end && quincy_space(data[words])) {
+                frame->binary.start = binary;
+                frame->binary.length = position - binary;
+                frame->address.start = address;
+                frame->address.length = words - address;
+                frame->description.start = quincy_skip_spaces(data, words, end);
+                frame->description.length = end - frame->description.start;
+                return 1;
+            }
+        }
+        position = address;
+    }
+
+    return 0;
+}
+
+/* the length of the architecture at position if whitespace follows it, otherwise 0 */
+static size_t quincy_architecture(const char *data, size_t position, size_t end)
+{
+    int i;
+
+    for (i = 0; quincy_architectures[i]; i++) {
+        size_t length = strlen(quincy_architectures[i]);
+        if (position + length < end && strncasecmp(data + position, quincy_architectures[i], length) == 0 && quincy_space(data[position + length]))
+            return length;
+    }
+
+    return 0;
+}
+
+/*
+ * /^\s*(\w+)\s*-\s*(\w+)\s*(\+)?(.+)\s+(architectures)\s+\<?([0-9A-Fa-f]{32})?>?\s*(.*)\s*$/i
+ *
+ * The binary name is as long as possible, so it ends before the last architecture
+ * with whitespace on both sides, and keeps all but one whitespace in front of it.
+ * Only if there is no room for it, the binary name starts in the whitespace or the
+ * end address before it, as the expression backtracks there.
+ */
+int quincy_match_image(const char *data, size_t start, size_t end, quincy_image *image)
+{
+    size_t position = quincy_skip_spaces(data, start, end);
+    size_t words, binary, architecture = 0;
+    size_t i;
+
+    image->load_address.start = position;
+    position = quincy_skip_words(data, position, end);
+    if (position == image->load_address.start) return 0;
+    image->load_address.length = position - image->load_address.start;
+
+    position = quincy_skip_spaces(data, position, end);
+    if (position >= end || data[position] != '-') return 0;
+
+    image->end_address.start = quincy_skip_spaces(data, position + 1, end);
+    position = quincy_skip_words(data, image->end_address.start, end);
+    if (position == image->end_address.start) return 0;
+    words = position;
+
+    /* the last architecture, the binary name takes at least one character before it */
+    position = end;
+    while (position > image->end_address.start + 3) {
+        position--;
+        if (quincy_space(data[position - 1]) && (architecture = quincy_architecture(data, position, end)) > 0) break;
+    }
+    if (architecture == 0) return 0;
+
+    /* the binary starts after the whitespace and the + sign, or backtracks into them and the end address */
+    binary = quincy_skip_spaces(data, words, end);
+    if (binary < end && data[binary] == '+' && binary + 1 <= position - 2) binary++;
+    else if (binary > position - 2) binary = position - 2;
+    image->end_address.length = (binary < words ? binary : words) - image->end_address.start;
+
+    image->binary.start = binary;
+    image->binary.length = position - 1 - binary;
+    image->platform.start = position;
+    image->platform.length = architecture;
+
+    position = quincy_skip_spaces(data, position + architecture, end);
+    if (position < end && data[position] == '<') position++;
+    image->uuid.start = position;
+    image->uuid.length = 0;
+    if (position + 32 <= end) {
+        for (i = 0; i < 32 && quincy_hex(data[position + i]); i++);
+        if (i == 32) {
+            image->uuid.length = 32;
+            position += 32;
+        }
+    }
+    if (position < end && data[position] == '>') position++;
+
+    image->path.start = quincy_skip_spaces(data, position, end);
+    image->path.length = end - image->path.start;
+
+    return 1;
+}
+
+int quincy_contains(const char *data, quincy_span span, const char *needle, size_t needle_length)
+{
+    size_t i;
+
+    if (needle_length > span.length) return 0;
+    for (i = 0; i + needle_length <= span.length; i++) {
+        if (memcmp(data + span.start + i, needle, needle_length) == 0) return 1;
+    }
+
+    return 0;
+}
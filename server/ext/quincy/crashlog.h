@@ -0,0 +1,94 @@
+/*
+ * Author: Andreas Linde <mail@andreaslinde.de>
+ *
+ * Copyright (c) 2009-2014 Andreas Linde.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Crash log scanning without any PHP dependency
+ *
+ * These functions do what crashLogSections(), crashLogField(), crashLogSection()
+ * and the stack frame and binary image expressions of admin/common.inc do, and
+ * have to give the same results. All positions are offsets into the crash log.
+ */
+
+#ifndef QUINCY_CRASHLOG_H
+#define QUINCY_CRASHLOG_H
+
+#include <stddef.h>
+
+#define QUINCY_NOT_FOUND ((size_t)-1)
+
+typedef struct {
+    size_t start;
+    size_t length;
+} quincy_span;
+
+typedef struct {
+    size_t path;
+    size_t exception_type;
+    size_t information;
+    size_t specific_backtrace;
+    size_t last_exception_backtrace;
+    size_t crashed_thread;
+    size_t crashed_thread_exact;
+    size_t binary_images;
+} quincy_sections;
+
+typedef struct {
+    quincy_span number;
+    quincy_span binary;
+    quincy_span address;
+    quincy_span description;
+} quincy_frame;
+
+typedef struct {
+    quincy_span load_address;
+    quincy_span end_address;
+    quincy_span binary;
+    quincy_span platform;
+    quincy_span uuid;
+    quincy_span path;
+} quincy_image;
+
+/* find the header fields and sections, unknown ones are QUINCY_NOT_FOUND */
+void quincy_scan_sections(const char *data, size_t length, quincy_sections *sections);
+
+/* the value of a header field starting at offset, returns 0 if offset is QUINCY_NOT_FOUND */
+int quincy_field(const char *data, size_t length, size_t offset, quincy_span *value);
+
+/* the lines of a section up to the next empty line, returns 0 if there is none */
+int quincy_section(const char *data, size_t length, size_t offset, quincy_span *section);
+
+/* match the line from start to end as a stack frame, returns 0 if it is none */
+int quincy_match_frame(const char *data, size_t start, size_t end, quincy_frame *frame);
+
+/* match the line from start to end as a binary image, returns 0 if it is none */
+int quincy_match_image(const char *data, size_t start, size_t end, quincy_image *image);
+
+/* find needle in the span, like strpos() */
+int quincy_contains(const char *data, quincy_span span, const char *needle, size_t needle_length);
+
+#endif
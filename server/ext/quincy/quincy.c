@@ -0,0 +1,551 @@
+/*
+ * Author: Andreas Linde <mail@andreaslinde.de>
+ *
+ * Copyright (c) 2009-2014 Andreas Linde.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * quincy_parse_crash() returns the same array as crashLogGroupArray() in
+ * admin/common.inc, which uses it instead of its own PHP code if this extension
+ * is loaded. Every step has to give exactly the result of the PHP code, so the
+ * crash groups don't depend on which parser is used. bench/crashlog_parse.php
+ * compares both on a corpus of crash logs.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <ctype.h>
+
+#include "php.h"
+#include "ext/standard/info.h"
+#include "ext/standard/url.h"
+#include "zend_smart_str.h"
+
+#include "php_quincy.h"
+#include "crashlog.h"
+
+#define QUINCY_TERMINATING "*** Terminating app due to uncaught exception "
+#define QUINCY_GARBAGE_COLLECTION "]: garbage collection is OFF"
+
+typedef struct {
+    quincy_image image;
+    zval load;
+    zval end;
+    int type;
+} quincy_binary_image;
+
+typedef struct {
+    void *items;
+    size_t count;
+    size_t capacity;
+} quincy_list;
+
+static void *quincy_list_add(quincy_list *list, size_t size)
+{
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 32;
+        list->items = erealloc(list->items, list->capacity * size);
+    }
+
+    return (char *)list->items + size * list->count++;
+}
+
+static void quincy_add_span(zval *array, const char *key, const char *data, quincy_span span)
+{
+    add_assoc_stringl(array, key, (char *)data + span.start, span.length);
+}
+
+static int quincy_span_equals(const char *data, quincy_span a, quincy_span b)
+{
+    return a.length == b.length && memcmp(data + a.start, data + b.start, a.length) == 0;
+}
+
+/* hexdec(), including its switch to a float for values beyond ZEND_LONG_MAX */
+static void quincy_hexdec(const char *data, quincy_span span, zval *result)
+{
+    zend_long cutoff = ZEND_LONG_MAX / 16;
+    int cutlim = ZEND_LONG_MAX % 16;
+    zend_long num = 0;
+    double fnum = 0;
+    int mode = 0;
+    size_t i;
+
+    for (i = 0; i < span.length; i++) {
+        char c = data[span.start + i];
+        int digit;
+
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else continue;
+
+        if (mode == 0) {
+            if (num < cutoff || (num == cutoff && digit <= cutlim)) {
+                num = num * 16 + digit;
+                continue;
+            }
+            fnum = (double)num;
+            mode = 1;
+        }
+        fnum = fnum * 16 + digit;
+    }
+
+    if (mode == 1) {
+        ZVAL_DOUBLE(result, fnum);
+    } else {
+        ZVAL_LONG(result, num);
+    }
+}
+
+/* the app directory like crashLogAppPath(), as a span of the Path header */
+static quincy_span quincy_app_path(const char *data, size_t length, quincy_sections *sections)
+{
+    quincy_span path = { 0, 0 };
+    int step;
+
+    if (!quincy_field(data, length, sections->path, &path)) {
+        path.length = 0;
+        return path;
+    }
+
+    /* remove app name, and the binary container on Mac OS X */
+    for (step = 0; step < 2; step++) {
+        size_t slash = path.length;
+        while (slash > 0 && data[path.start + slash - 1] != '/') slash--;
+        path.length = slash > 0 ? slash - 1 : 0;
+
+        if (step == 0 && path.length >= 4 && memcmp(data + path.start + path.length - 4, ".app", 4) == 0) break;
+    }
+
+    return path;
+}
+
+/* the stack frames of the first of the backtraces which has any, like parseThread() */
+static void quincy_parse_frames(const char *data, size_t length, quincy_sections *sections, quincy_list *frames)
+{
+    size_t offsets[4];
+    int i;
+
+    offsets[0] = sections->specific_backtrace;
+    offsets[1] = sections->last_exception_backtrace;
+    offsets[2] = sections->crashed_thread;
+    offsets[3] = sections->crashed_thread_exact;
+
+    for (i = 0; i < 4 && frames->count == 0; i++) {
+        quincy_span section;
+        size_t start, end;
+
+        if (!quincy_section(data, length, offsets[i], &section)) continue;
+
+        end = section.start + section.length;
+        for (start = section.start; start <= end; ) {
+            const char *newline = memchr(data + start, '\n', end - start);
+            size_t line = newline ? (size_t)(newline - data) : end;
+            quincy_frame frame;
+
+            if (quincy_match_frame(data, start, line, &frame))
+                *(quincy_frame *)quincy_list_add(frames, sizeof(quincy_frame)) = frame;
+            start = line + 1;
+        }
+    }
+}
+
+/* the binary images like crashLogBinaryImages(), returns 1 if a substrate library is loaded */
+static int quincy_parse_images(const char *data, size_t length, quincy_sections *sections, quincy_span app_path, quincy_list *images)
+{
+    int jailbreak = 0;
+    size_t start;
+
+    if (sections->binary_images == QUINCY_NOT_FOUND) return 0;
+
+    for (start = sections->binary_images; start <= length; ) {
+        const char *newline = memchr(data + start, '\n', length - start);
+        size_t line = newline ? (size_t)(newline - data) : length;
+        quincy_binary_image image;
+
+        if (quincy_match_image(data, start, line, &image.image)) {
+            if (quincy_contains(data, image.image.path, "MobileSubstrate", 15) ||
+                quincy_contains(data, image.image.path, "CydiaSubstrate", 14) ||
+                quincy_contains(data, image.image.binary, "MobileSubstrate", 15) ||
+                quincy_contains(data, image.image.binary, "CydiaSubstrate", 14))
+            {
+                jailbreak = 1;
+            }
+
+            if (images->count == 0) {
+                image.type = 0;
+            } else if (app_path.length > 0 && quincy_contains(data, image.image.path, data + app_path.start, app_path.length)) {
+                image.type = 1;
+            } else {
+                image.type = 2;
+            }
+
+            quincy_hexdec(data, image.image.load_address, &image.load);
+            quincy_hexdec(data, image.image.end_address, &image.end);
+            *(quincy_binary_image *)quincy_list_add(images, sizeof(quincy_binary_image)) = image;
+        }
+        start = line + 1;
+    }
+
+    return jailbreak;
+}
+
+/* the app image for the binary name of a stack frame like crashAppImageForBinary(), or NULL */
+static quincy_binary_image *quincy_app_image(const char *data, quincy_list *images, const char *binary, size_t binary_length)
+{
+    quincy_binary_image *list = images->items;
+    size_t i;
+
+    for (i = 0; i < images->count; i++) {
+        quincy_span name = list[i].image.binary;
+        if (list[i].type < 2 && name.length >= binary_length && memcmp(data + name.start, binary, binary_length) == 0)
+            return &list[i];
+    }
+
+    return NULL;
+}
+
+/* the string comparison of PHP for two non numeric strings */
+static int quincy_compare(const char *data, quincy_span a, quincy_span b)
+{
+    int result = memcmp(data + a.start, data + b.start, MIN(a.length, b.length));
+
+    if (result != 0) return result;
+    return (a.length > b.length) - (a.length < b.length);
+}
+
+static void quincy_replace_all(smart_str *result, const char *text, size_t length, const char *needle, size_t needle_length)
+{
+    size_t i = 0;
+
+    while (i < length) {
+        if (i + needle_length <= length && memcmp(text + i, needle, needle_length) == 0) {
+            i += needle_length;
+        } else {
+            smart_str_appendc(result, text[i++]);
+        }
+    }
+}
+
+/* the characters trim() removes by default */
+static int quincy_trim_character(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\0' || c == '\x0B';
+}
+
+/* the reason from the Application Specific Information as crashLogGroupArray() cleans it up */
+static zend_string *quincy_reason(const char *data, quincy_span information)
+{
+    zend_string *decoded;
+    smart_str escaped = { 0 };
+    smart_str reason = { 0 };
+    zval function, parameters[3], html;
+    const char *text;
+    char *line;
+    size_t length, i, start, end, close;
+    int garbage_collection = 0;
+
+    /* utf8_urldecode() */
+    decoded = zend_string_init(data + information.start, information.length, 0);
+    ZSTR_LEN(decoded) = php_url_decode(ZSTR_VAL(decoded), ZSTR_LEN(decoded));
+    text = ZSTR_VAL(decoded);
+    length = ZSTR_LEN(decoded);
+    for (i = 0; i < length; i++) {
+        size_t digits = 0;
+
+        if (text[i] == '%' && i + 1 < length && (text[i + 1] == 'u' || text[i + 1] == 'U')) {
+            while (digits < 4 && i + 2 + digits < length && isxdigit((unsigned char)text[i + 2 + digits])) digits++;
+            if (digits >= 3) {
+                smart_str_appendl(&escaped, "&#x", 3);
+                smart_str_appendl(&escaped, text + i + 2, digits);
+                smart_str_appendc(&escaped, ';');
+                i += 1 + digits;
+                continue;
+            }
+        }
+        smart_str_appendc(&escaped, text[i]);
+    }
+    zend_string_release(decoded);
+    smart_str_appendl(&escaped, "", 0);
+    smart_str_0(&escaped);
+
+    ZVAL_STRING(&function, "html_entity_decode");
+    ZVAL_STR(&parameters[0], escaped.s);
+    ZVAL_LONG(&parameters[1], 0);
+    ZVAL_STRING(&parameters[2], "UTF-8");
+    ZVAL_UNDEF(&html);
+    if (call_user_function(NULL, NULL, &function, &html, 3, parameters) != SUCCESS || Z_TYPE(html) != IS_STRING) {
+        zval_ptr_dtor(&html);
+        ZVAL_STR_COPY(&html, escaped.s);
+    }
+    zval_ptr_dtor(&function);
+    zval_ptr_dtor(&parameters[0]);
+    zval_ptr_dtor(&parameters[2]);
+
+    quincy_replace_all(&reason, Z_STRVAL(html), Z_STRLEN(html), QUINCY_TERMINATING, sizeof(QUINCY_TERMINATING) - 1);
+    zval_ptr_dtor(&html);
+    smart_str_appendl(&reason, "", 0);
+    smart_str_0(&reason);
+
+    /* /^(objc\[[^\]]*\]\: garbage collection is OFF)$/i on the reason without line breaks */
+    text = ZSTR_VAL(reason.s);
+    length = ZSTR_LEN(reason.s);
+    line = emalloc(length + 1);
+    for (i = 0, close = 0; i < length; i++) {
+        if (text[i] != '\n') line[close++] = text[i];
+    }
+    if (close >= 5 && strncasecmp(line, "objc[", 5) == 0) {
+        char *bracket = memchr(line + 5, ']', close - 5);
+        garbage_collection = bracket && (size_t)(line + close - bracket) == sizeof(QUINCY_GARBAGE_COLLECTION) - 1 &&
+            strncasecmp(bracket, QUINCY_GARBAGE_COLLECTION, sizeof(QUINCY_GARBAGE_COLLECTION) - 1) == 0;
+    }
+    efree(line);
+    if (garbage_collection) {
+        smart_str_free(&reason);
+        return zend_string_init("No reason found", sizeof("No reason found") - 1, 0);
+    }
+
+    /* trim() */
+    start = 0;
+    end = length;
+    while (start < end && quincy_trim_character(text[start])) start++;
+    while (end > start && quincy_trim_character(text[end - 1])) end--;
+
+    decoded = zend_string_init(text + start, end - start, 0);
+    smart_str_free(&reason);
+
+    return decoded;
+}
+
+/* case insensitive like sort() with SORT_STRING | SORT_FLAG_CASE */
+static int quincy_binary_compare(const char *data, quincy_span a, quincy_span b)
+{
+    size_t i, length = MIN(a.length, b.length);
+
+    for (i = 0; i < length; i++) {
+        int c1 = tolower((unsigned char)data[a.start + i]);
+        int c2 = tolower((unsigned char)data[b.start + i]);
+        if (c1 != c2) return c1 - c2;
+    }
+
+    return (a.length > b.length) - (a.length < b.length);
+}
+
+/* the binaries of the frames before the crashing one, unique and sorted like crashLogGroupArray() joins them */
+static void quincy_binaries(smart_str *result, const char *data, quincy_span *binaries, size_t count)
+{
+    size_t unique = 0, i, j;
+
+    /* array_unique() keeps the first of equal names, the insertion sort is stable */
+    for (i = 0; i < count; i++) {
+        quincy_span binary = binaries[i];
+
+        for (j = 0; j < unique && !quincy_span_equals(data, binaries[j], binary); j++);
+        if (j < unique) continue;
+
+        for (j = unique; j > 0 && quincy_binary_compare(data, binaries[j - 1], binary) > 0; j--)
+            binaries[j] = binaries[j - 1];
+        binaries[j] = binary;
+        unique++;
+    }
+
+    for (i = 0; i < unique; i++) {
+        if (i > 0) smart_str_appendc(result, ',');
+        smart_str_appendl(result, data + binaries[i].start, binaries[i].length);
+    }
+}
+
+PHP_FUNCTION(quincy_parse_crash)
+{
+    zend_string *logdata;
+    const char *data;
+    size_t length, i;
+    quincy_sections sections;
+    quincy_span exception_type, information, app_path;
+    quincy_list frames = { NULL, 0, 0 };
+    quincy_list images = { NULL, 0, 0 };
+    quincy_span *binaries = NULL;
+    size_t binaries_count = 0;
+    zend_string *reason = NULL;
+    smart_str group_address = { 0 };
+    quincy_span location = { 0, 0 };
+    int jailbreak;
+    zval list, item;
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS(), "S", &logdata) == FAILURE) {
+        return;
+    }
+
+    data = ZSTR_VAL(logdata);
+    length = ZSTR_LEN(logdata);
+
+    quincy_scan_sections(data, length, &sections);
+    if (!quincy_field(data, length, sections.exception_type, &exception_type)) {
+        exception_type.start = 0;
+        exception_type.length = 0;
+    }
+    app_path = quincy_app_path(data, length, &sections);
+    jailbreak = quincy_parse_images(data, length, &sections, app_path, &images);
+
+    if (quincy_section(data, length, sections.information, &information)) {
+        reason = quincy_reason(data, information);
+    }
+
+    quincy_parse_frames(data, length, &sections, &frames);
+    if (frames.count > 0) {
+        quincy_frame *frame = frames.items;
+        binaries = safe_emalloc(frames.count, sizeof(quincy_span), 0);
+
+        for (i = 0; i < frames.count; i++, frame++) {
+            const char *binary = data + frame->binary.start;
+            size_t binary_length = frame->binary.length;
+            quincy_binary_image *image;
+
+            binaries[binaries_count++] = frame->binary;
+
+            /* if the stack trace contains a string from PLCrashReporter, then this is not the crash reason */
+            if (quincy_contains(data, frame->description, "PLCrash", 7) || quincy_contains(data, frame->description, "uncaught_exception_handler", 26))
+                continue;
+
+            /* a cut off name only matches images starting with "...", as in the PHP code */
+            if (binary_length >= 3 && memcmp(binary + binary_length - 3, "...", 3) == 0) {
+                binary += binary_length - 3;
+                binary_length = 3;
+            }
+
+            image = quincy_app_image(data, &images, binary, binary_length);
+            if (image) {
+                location = frame->description;
+                if (quincy_compare(data, frame->address, image->image.load_address) > 0) {
+                    zval address;
+                    zend_long difference;
+                    char hex[32];
+
+                    quincy_hexdec(data, frame->address, &address);
+                    if (Z_TYPE(address) == IS_LONG && Z_TYPE(image->load) == IS_LONG) {
+                        difference = Z_LVAL(address) - Z_LVAL(image->load);
+                    } else {
+                        difference = zend_dval_to_lval(zval_get_double(&address) - zval_get_double(&image->load));
+                    }
+                    snprintf(hex, sizeof(hex), "%llx", (unsigned long long)(zend_ulong)difference);
+                    smart_str_appends(&group_address, hex);
+                } else {
+                    smart_str_appendl(&group_address, data + frame->address.start, frame->address.length);
+                }
+                break;
+            }
+        }
+    }
+
+    array_init(return_value);
+
+    if (reason && ZSTR_LEN(reason) > 0) {
+        add_assoc_str(return_value, "reason", reason);
+        reason = NULL;
+    } else if (binaries_count > 0) {
+        smart_str text = { 0 };
+        smart_str_appends(&text, "No Reason found. Full stack trace includes ");
+        quincy_binaries(&text, data, binaries, binaries_count);
+        smart_str_appendc(&text, '.');
+        smart_str_0(&text);
+        add_assoc_str(return_value, "reason", text.s);
+    }
+    if (reason) zend_string_release(reason);
+
+    add_assoc_stringl(return_value, "groupAddress", group_address.s ? ZSTR_VAL(group_address.s) : "", group_address.s ? ZSTR_LEN(group_address.s) : 0);
+    smart_str_free(&group_address);
+    quincy_add_span(return_value, "location", data, location);
+    quincy_add_span(return_value, "exceptionType", data, exception_type);
+    add_assoc_long(return_value, "jailbreak", jailbreak);
+
+    array_init_size(&list, (uint32_t)frames.count);
+    for (i = 0; i < frames.count; i++) {
+        quincy_frame *frame = (quincy_frame *)frames.items + i;
+        array_init_size(&item, 4);
+        quincy_add_span(&item, "number", data, frame->number);
+        quincy_add_span(&item, "binary", data, frame->binary);
+        quincy_add_span(&item, "address", data, frame->address);
+        quincy_add_span(&item, "description", data, frame->description);
+        add_next_index_zval(&list, &item);
+    }
+    add_assoc_zval(return_value, "frames", &list);
+
+    array_init_size(&list, (uint32_t)images.count);
+    for (i = 0; i < images.count; i++) {
+        quincy_binary_image *image = (quincy_binary_image *)images.items + i;
+        array_init_size(&item, 9);
+        quincy_add_span(&item, "loadAddress", data, image->image.load_address);
+        quincy_add_span(&item, "endAddress", data, image->image.end_address);
+        quincy_add_span(&item, "binary", data, image->image.binary);
+        quincy_add_span(&item, "platform", data, image->image.platform);
+        quincy_add_span(&item, "uuid", data, image->image.uuid);
+        quincy_add_span(&item, "path", data, image->image.path);
+        add_assoc_zval(&item, "load", &image->load);
+        add_assoc_zval(&item, "end", &image->end);
+        add_assoc_long(&item, "type", image->type);
+        add_next_index_zval(&list, &item);
+    }
+    add_assoc_zval(return_value, "images", &list);
+
+    if (binaries) efree(binaries);
+    if (frames.items) efree(frames.items);
+    if (images.items) efree(images.items);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_quincy_parse_crash, 0, 0, 1)
+    ZEND_ARG_INFO(0, logdata)
+ZEND_END_ARG_INFO()
+
+static const zend_function_entry quincy_functions[] = {
+    PHP_FE(quincy_parse_crash, arginfo_quincy_parse_crash)
+    PHP_FE_END
+};
+
+PHP_MINFO_FUNCTION(quincy)
+{
+    php_info_print_table_start();
+    php_info_print_table_row(2, "QuincyKit crash log parser", "enabled");
+    php_info_print_table_row(2, "Version", PHP_QUINCY_VERSION);
+    php_info_print_table_end();
+}
+
+zend_module_entry quincy_module_entry = {
+    STANDARD_MODULE_HEADER,
+    "quincy",
+    quincy_functions,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    PHP_MINFO(quincy),
+    PHP_QUINCY_VERSION,
+    STANDARD_MODULE_PROPERTIES
+};
+
+#ifdef COMPILE_DL_QUINCY
+ZEND_GET_MODULE(quincy)
+#endif
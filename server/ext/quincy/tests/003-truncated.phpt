@@ -0,0 +1,70 @@
+--TEST--
+quincy_parse_crash() on a crash log cut off in the binary images
+--SKIPIF--
+<?php if (!extension_loaded('quincy')) die('skip quincy extension not loaded'); ?>
+--FILE--
+<?php
+$log = <<<'LOG'
+Incident Identifier: 7E2E8E6C-1C5D-4F8A-9D37-1B0F5E7A2C11
+CrashReporter Key:   0b9d2e0c5f3b4a1e8c7d6f5a4b3c2d1e0f9a8b7c
+Hardware Model:      iPhone6,2
+Process:         QuincyDemo [1234]
+Path:            /var/mobile/Applications/2B3C4D5E-6F70-4182-9A3B-4C5D6E7F8091/QuincyDemo.app/QuincyDemo
+Identifier:      de.buzzworks.QuincyDemo
+Version:         1.0 (1.0)
+Code Type:       ARM (Native)
+Parent Process:  launchd [1]
+
+Date/Time:       2014-03-12 10:15:42.123 +0100
+OS Version:      iOS 7.0.6 (11B651)
+Report Version:  104
+
+Exception Type:  EXC_BAD_ACCESS (SIGSEGV)
+Exception Codes: KERN_INVALID_ADDRESS at 0x00000000
+Triggered by Thread:  0
+
+Thread 0 Crashed:
+0   libobjc.A.dylib               	0x3a8f5b66 objc_msgSend + 6
+1   QuincyKit                     	0x00021a3c -[BWQuincyManager startManager] (BWQuincyManager.m:312)
+2   QuincyDemo                    	0x0000a1f4 -[QuincyDemoViewController crash:] (QuincyDemoViewController.m:42)
+3   UIKit                         	0x32a1c0ab -[UIApplication sendAction:to:from:forEvent:] + 90
+4   QuincyDemo                    	0x00009e31 main (main.m:16)
+
+Thread 1:
+0   libsystem_kernel.dylib        	0x3aea8a8c kevent64 + 24
+
+Binary Images:
+0x8000 - 0x1bfff +QuincyDemo armv7  <5a3d1e7b9c2f4e8a8b6d0c1f2e3a4b5c> /var/mobile/Applications/2B3C4D5E-6F70-4182-9A3B-4C5D6E7F8091/QuincyDemo.app/QuincyDemo
+0x1f000 - 0x2afff +QuincyKit armv7  <0c1d2e3f4a5b6c7d8e9f0a1b2c3d4e5f> /var/mobile/Applications/2B3C4D5E-6F70-4182-9A3B-4C5D6E7F8091/QuincyDemo.app/Frameworks/QuincyKit.framework/QuincyKit
+0x32a0b000 - 0x32bc7fff  UIKit armv7  <e5c2b0a7d4f1483c9a6b2d0e8f7c1a3b> /System/Library/Frameworks/UIKit.framework/UIKit
+0x3a8ef000 - 0x3a9f9fff  libobjc.A.dylib armv7  <b8f4c3e2a1d04f6e9c7b5a3d2e1f0c9b> /usr/lib/libobjc.A.dylib
+0x3ae95000 - 0x3aeadfff  libsystem_kernel.dylib armv7  <f0e1d2c3b4a5968778695a4b3c2d1e0f> /usr/lib/system/libsystem_kernel.dylib
+LOG;
+$log = substr($log, 0, strpos($log, '<e5c2b0a7') + 9);
+
+$expected = array(
+  'reason' => "No Reason found. Full stack trace includes libobjc.A.dylib,QuincyKit.",
+  'groupAddress' => "0x00021a3c",
+  'location' => "-[BWQuincyManager startManager] (BWQuincyManager.m:312)",
+  'exceptionType' => "EXC_BAD_ACCESS (SIGSEGV)",
+  'jailbreak' => 0,
+  'frames' => array(
+    array('number' => "0", 'binary' => "libobjc.A.dylib", 'address' => "0x3a8f5b66", 'description' => "objc_msgSend + 6"),
+    array('number' => "1", 'binary' => "QuincyKit", 'address' => "0x00021a3c", 'description' => "-[BWQuincyManager startManager] (BWQuincyManager.m:312)"),
+    array('number' => "2", 'binary' => "QuincyDemo", 'address' => "0x0000a1f4", 'description' => "-[QuincyDemoViewController crash:] (QuincyDemoViewController.m:42)"),
+    array('number' => "3", 'binary' => "UIKit", 'address' => "0x32a1c0ab", 'description' => "-[UIApplication sendAction:to:from:forEvent:] + 90"),
+    array('number' => "4", 'binary' => "QuincyDemo", 'address' => "0x00009e31", 'description' => "main (main.m:16)"),
+  ),
+  'images' => array(
+    array('loadAddress' => "0x8000", 'endAddress' => "0x1bfff", 'binary' => "QuincyDemo", 'platform' => "armv7", 'uuid' => "5a3d1e7b9c2f4e8a8b6d0c1f2e3a4b5c", 'path' => "/var/mobile/Applications/2B3C4D5E-6F70-4182-9A3B-4C5D6E7F8091/QuincyDemo.app/QuincyDemo", 'load' => 32768, 'end' => 114687, 'type' => 0),
+    array('loadAddress' => "0x1f000", 'endAddress' => "0x2afff", 'binary' => "QuincyKit", 'platform' => "armv7", 'uuid' => "0c1d2e3f4a5b6c7d8e9f0a1b2c3d4e5f", 'path' => "/var/mobile/Applications/2B3C4D5E-6F70-4182-9A3B-4C5D6E7F8091/QuincyDemo.app/Frameworks/QuincyKit.framework/QuincyKit", 'load' => 126976, 'end' => 176127, 'type' => 1),
+    array('loadAddress' => "0x32a0b000", 'endAddress' => "0x32bc7fff", 'binary' => "UIKit", 'platform' => "armv7", 'uuid' => "", 'path' => "e5c2b0a7", 'load' => 849391616, 'end' => 851214335, 'type' => 2),
+  ),
+);
+
+$result = quincy_parse_crash($log);
+var_dump($result === $expected);
+if ($result !== $expected) var_export($result);
+?>
+--EXPECT--
+bool(true)
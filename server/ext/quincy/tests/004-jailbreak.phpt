@@ -0,0 +1,62 @@
+--TEST--
+quincy_parse_crash() on an unsymbolicated crash log with MobileSubstrate images
+--SKIPIF--
+<?php if (!extension_loaded('quincy')) die('skip quincy extension not loaded'); ?>
+--FILE--
+<?php
+$log = <<<'LOG'
+Incident Identifier: 7E2E8E6C-1C5D-4F8A-9D37-1B0F5E7A2C11
+CrashReporter Key:   0b9d2e0c5f3b4a1e8c7d6f5a4b3c2d1e0f9a8b7c
+Hardware Model:      iPhone6,2
+Process:         QuincyDemo [1234]
+Path:            /var/mobile/Applications/2B3C4D5E-6F70-4182-9A3B-4C5D6E7F8091/QuincyDemo.app/QuincyDemo
+Identifier:      de.buzzworks.QuincyDemo
+Version:         1.0 (1.0)
+Code Type:       ARM (Native)
+Parent Process:  launchd [1]
+
+Date/Time:       2014-03-12 10:15:42.123 +0100
+OS Version:      iOS 7.0.6 (11B651)
+Report Version:  104
+
+Exception Type:  EXC_BAD_ACCESS (SIGBUS)
+Exception Codes: KERN_PROTECTION_FAILURE at 0x0000000c
+Triggered by Thread:  0
+
+Thread 0 Crashed:
+0   WinterBoard.dylib             	0x0014b3f2 0x148000 + 13298
+1   QuincyDemo                    	0x0000c2d5 0x8000 + 17109
+2   UIKit                         	0x32a2f1c3 0x32a0b000 + 147907
+
+Binary Images:
+0x8000 - 0x1bfff +QuincyDemo armv7  <5a3d1e7b9c2f4e8a8b6d0c1f2e3a4b5c> /var/mobile/Applications/2B3C4D5E-6F70-4182-9A3B-4C5D6E7F8091/QuincyDemo.app/QuincyDemo
+0x100000 - 0x105fff  MobileSubstrate.dylib armv7  <3f1e2d4c5b6a79880f1e2d3c4b5a6978> /Library/MobileSubstrate/MobileSubstrate.dylib
+0x148000 - 0x15bfff  WinterBoard.dylib armv7  <9a8b7c6d5e4f30211203a4b5c6d7e8f9> /Library/MobileSubstrate/DynamicLibraries/WinterBoard.dylib
+0x32a0b000 - 0x32bc7fff  UIKit armv7  <e5c2b0a7d4f1483c9a6b2d0e8f7c1a3b> /System/Library/Frameworks/UIKit.framework/UIKit
+LOG;
+
+$expected = array(
+  'reason' => "No Reason found. Full stack trace includes QuincyDemo,WinterBoard.dylib.",
+  'groupAddress' => "0x0000c2d5",
+  'location' => "0x8000 + 17109",
+  'exceptionType' => "EXC_BAD_ACCESS (SIGBUS)",
+  'jailbreak' => 1,
+  'frames' => array(
+    array('number' => "0", 'binary' => "WinterBoard.dylib", 'address' => "0x0014b3f2", 'description' => "0x148000 + 13298"),
+    array('number' => "1", 'binary' => "QuincyDemo", 'address' => "0x0000c2d5", 'description' => "0x8000 + 17109"),
+    array('number' => "2", 'binary' => "UIKit", 'address' => "0x32a2f1c3", 'description' => "0x32a0b000 + 147907"),
+  ),
+  'images' => array(
+    array('loadAddress' => "0x8000", 'endAddress' => "0x1bfff", 'binary' => "QuincyDemo", 'platform' => "armv7", 'uuid' => "5a3d1e7b9c2f4e8a8b6d0c1f2e3a4b5c", 'path' => "/var/mobile/Applications/2B3C4D5E-6F70-4182-9A3B-4C5D6E7F8091/QuincyDemo.app/QuincyDemo", 'load' => 32768, 'end' => 114687, 'type' => 0),
+    array('loadAddress' => "0x100000", 'endAddress' => "0x105fff", 'binary' => "MobileSubstrate.dylib", 'platform' => "armv7", 'uuid' => "3f1e2d4c5b6a79880f1e2d3c4b5a6978", 'path' => "/Library/MobileSubstrate/MobileSubstrate.dylib", 'load' => 1048576, 'end' => 1073151, 'type' => 2),
+    array('loadAddress' => "0x148000", 'endAddress' => "0x15bfff", 'binary' => "WinterBoard.dylib", 'platform' => "armv7", 'uuid' => "9a8b7c6d5e4f30211203a4b5c6d7e8f9", 'path' => "/Library/MobileSubstrate/DynamicLibraries/WinterBoard.dylib", 'load' => 1343488, 'end' => 1425407, 'type' => 2),
+    array('loadAddress' => "0x32a0b000", 'endAddress' => "0x32bc7fff", 'binary' => "UIKit", 'platform' => "armv7", 'uuid' => "e5c2b0a7d4f1483c9a6b2d0e8f7c1a3b", 'path' => "/System/Library/Frameworks/UIKit.framework/UIKit", 'load' => 849391616, 'end' => 851214335, 'type' => 2),
+  ),
+);
+
+$result = quincy_parse_crash($log);
+var_dump($result === $expected);
+if ($result !== $expected) var_export($result);
+?>
+--EXPECT--
+bool(true)
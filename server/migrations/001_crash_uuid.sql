@@ -0,0 +1,11 @@
+-- Adds the incident identifier of the crash reports to the `crash` table
+--
+-- Crashes with the same identifier are only stored once, so a client sending a
+-- submission again after a failed response doesn't create duplicates.
+-- Existing rows keep a NULL identifier, which the unique key allows any number of times.
+--
+-- Apply with: mysql -u <user> -p <database> < 001_crash_uuid.sql
+
+ALTER TABLE `crash`
+  ADD `uuid` varchar(36) collate utf8_unicode_ci default NULL,
+  ADD UNIQUE KEY `uuid` (`uuid`);
@@ -0,0 +1,41 @@
+-- Adds a 64 bit fingerprint of the pattern to the `crash_groups` table
+--
+-- Groups are found with a unique key on bundle identifier, version and fingerprint,
+-- so incoming crashes create or count their group with a single
+-- INSERT ... ON DUPLICATE KEY UPDATE and concurrent submissions can't create a group twice.
+-- Groups that did get created twice are merged into the oldest one before the key is added.
+-- Crashes that got assigned to a group of another app with the same version string
+-- stay there, use Regroup in the admin UI to move them.
+--
+-- Apply with: mysql -u <user> -p <database> < 002_crash_groups_fingerprint.sql
+
+ALTER TABLE `crash_groups`
+  ADD `fingerprint` bigint(20) unsigned NOT NULL default '0' AFTER `pattern`;
+
+-- the same value crashGroupFingerprint() in admin/common.inc calculates
+UPDATE `crash_groups` SET `fingerprint` = CONV(LEFT(MD5(`pattern`), 16), 16, 10);
+
+CREATE TEMPORARY TABLE `crash_groups_merge` AS
+  SELECT `duplicate`.`id`, `first`.`id` AS `keep`
+  FROM `crash_groups` `duplicate`
+  JOIN (SELECT `bundleidentifier`, `affected`, `fingerprint`, MIN(`id`) AS `id` FROM `crash_groups`
+        GROUP BY `bundleidentifier`, `affected`, `fingerprint` HAVING COUNT(*) > 1) `first`
+    ON `duplicate`.`bundleidentifier` = `first`.`bundleidentifier` AND `duplicate`.`affected` = `first`.`affected`
+    AND `duplicate`.`fingerprint` = `first`.`fingerprint` AND `duplicate`.`id` <> `first`.`id`;
+
+UPDATE `crash` JOIN `crash_groups_merge` ON `crash`.`groupid` = `crash_groups_merge`.`id`
+  SET `crash`.`groupid` = `crash_groups_merge`.`keep`;
+
+UPDATE `crash_groups` JOIN (SELECT `crash_groups_merge`.`keep`, SUM(`duplicate`.`amount`) AS `amount`, MAX(`duplicate`.`latesttimestamp`) AS `latesttimestamp`
+                            FROM `crash_groups_merge` JOIN `crash_groups` `duplicate` ON `duplicate`.`id` = `crash_groups_merge`.`id`
+                            GROUP BY `crash_groups_merge`.`keep`) `merged` ON `crash_groups`.`id` = `merged`.`keep`
+  SET `crash_groups`.`amount` = `crash_groups`.`amount` + `merged`.`amount`,
+      `crash_groups`.`latesttimestamp` = GREATEST(`crash_groups`.`latesttimestamp`, `merged`.`latesttimestamp`);
+
+DELETE `crash_groups` FROM `crash_groups` JOIN `crash_groups_merge` ON `crash_groups`.`id` = `crash_groups_merge`.`id`;
+
+DROP TEMPORARY TABLE `crash_groups_merge`;
+
+-- the bundle identifier is indexed with 191 characters, which keeps the utf8 key within 767 bytes
+ALTER TABLE `crash_groups`
+  ADD UNIQUE KEY `fingerprint` (`bundleidentifier`(191), `affected`, `fingerprint`);
@@ -0,0 +1,12 @@
+-- Adds the fingerprint version to the `crash_groups` table
+--
+-- Version 1 fingerprints are the hash of the pattern, version 2 fingerprints the hash of
+-- the top app frames of the crash, see $group_fingerprint in config.php. Groups of both
+-- versions can exist for the same app version, existing groups are version 1.
+--
+-- Apply with: mysql -u <user> -p <database> < 003_crash_groups_fingerprint_version.sql
+
+ALTER TABLE `crash_groups`
+  ADD `fingerprintversion` tinyint(3) unsigned NOT NULL default '1' AFTER `fingerprint`,
+  DROP KEY `fingerprint`,
+  ADD UNIQUE KEY `fingerprint` (`bundleidentifier`(191), `affected`, `fingerprintversion`, `fingerprint`);
@@ -0,0 +1,28 @@
+-- Adds the `crash_issues` table, which links the crash groups of all versions of an app
+--
+-- Groups are linked to an issue by the symbol names of their top app stack frames, when
+-- a group is created from a symbolicated crash log or when the first of its crashes gets
+-- symbolicated through crash_update.php. The issue keeps the total amount of crashes of
+-- its groups. Existing groups are not linked.
+--
+-- Apply with: mysql -u <user> -p <database> < 004_crash_issues.sql
+
+CREATE TABLE IF NOT EXISTS `crash_issues` (
+  `id` bigint(20) unsigned NOT NULL auto_increment,
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci default NULL,
+  `fingerprint` bigint(20) unsigned NOT NULL default '0',
+  `pattern` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  `location` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  `exception` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  `reason` text collate utf8_unicode_ci,
+  `groupcount` int(11) NOT NULL default '0',
+  `amount` bigint(20) default '0',
+  `latesttimestamp` bigint(20) default '0',
+  PRIMARY KEY  (`id`),
+  UNIQUE KEY `fingerprint` (`bundleidentifier`(191), `fingerprint`),
+  KEY `amount` (`bundleidentifier`(191), `amount`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
+
+ALTER TABLE `crash_groups`
+  ADD `issueid` bigint(20) unsigned NOT NULL default '0' AFTER `fingerprintversion`,
+  ADD KEY `issueid` (`issueid`);
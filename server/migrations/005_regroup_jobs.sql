@@ -0,0 +1,21 @@
+-- Adds the `regroup_jobs` table, which keeps the progress of regrouping the crashes of a version
+--
+-- regroup.php and cli/regroup.php regroup crashes in chunks and save the id of the last
+-- regrouped crash with every chunk, so a regroup that stopped continues where it was.
+--
+-- Apply with: mysql -u <user> -p <database> < 005_regroup_jobs.sql
+
+CREATE TABLE IF NOT EXISTS `regroup_jobs` (
+  `id` bigint(20) unsigned NOT NULL auto_increment,
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci default NULL,
+  `affected` varchar(20) collate utf8_unicode_ci default NULL,
+  `groupid` bigint(20) NOT NULL default '0',
+  `lastid` bigint(20) unsigned NOT NULL default '0',
+  `processed` bigint(20) NOT NULL default '0',
+  `total` bigint(20) NOT NULL default '0',
+  `started` bigint(20) NOT NULL default '0',
+  `updated` bigint(20) NOT NULL default '0',
+  `done` tinyint(4) NOT NULL default '0',
+  PRIMARY KEY  (`id`),
+  UNIQUE KEY `job` (`bundleidentifier`(191), `affected`, `groupid`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
@@ -0,0 +1,10 @@
+-- Adds the shadow column `regroupid` to the `crash` table
+--
+-- cli/regroup_history.php writes the new group of every crash there while it
+-- regroups the whole history, and moves it into `groupid` in one transaction
+-- once all crashes are done.
+--
+-- Apply with: mysql -u <user> -p <database> < 006_crash_regroupid.sql
+
+ALTER TABLE `crash`
+  ADD `regroupid` bigint(20) unsigned default NULL AFTER `uuid`;
@@ -0,0 +1,22 @@
+-- Adds the `crash_frames` table with the parsed stack frames of each crash
+--
+-- crash_v300.php stores the frames of new crashes according to $ingest_frames in
+-- config.php, crash_update.php replaces them once a crash got symbolicated.
+-- Crashes stored before are not parsed again.
+--
+-- Apply with: mysql -u <user> -p <database> < 007_crash_frames.sql
+
+CREATE TABLE IF NOT EXISTS `crash_frames` (
+  `crashid` bigint(20) unsigned NOT NULL,
+  `thread` smallint(6) NOT NULL default '0',
+  `crashed` tinyint(3) unsigned NOT NULL default '0',
+  `frame` smallint(5) unsigned NOT NULL default '0',
+  `image` varchar(64) collate utf8_unicode_ci NOT NULL default '',
+  `imageuuid` binary(16) default NULL,
+  `offset` bigint(20) unsigned NOT NULL default '0',
+  `symbol` varchar(250) collate utf8_unicode_ci default NULL,
+  PRIMARY KEY  (`crashid`, `thread`, `frame`),
+  KEY `symbol` (`symbol`(191)),
+  KEY `image` (`imageuuid`, `offset`),
+  CONSTRAINT `FK_FRAMES_CRASHID` FOREIGN KEY (`crashid`) REFERENCES `crash` (`id`) ON DELETE CASCADE
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
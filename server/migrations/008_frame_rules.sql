@@ -0,0 +1,15 @@
+-- Adds the `frame_rules` table with the rules of each app which stack frames are not used for grouping
+--
+-- The rules are edited in the admin UI of an app and apply to new crashes,
+-- existing crashes get grouped by them when their version is regrouped.
+--
+-- Apply with: mysql -u <user> -p <database> < 008_frame_rules.sql
+
+CREATE TABLE IF NOT EXISTS `frame_rules` (
+  `id` bigint(20) unsigned NOT NULL auto_increment,
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci NOT NULL,
+  `type` tinyint(3) unsigned NOT NULL default '0',
+  `value` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  PRIMARY KEY  (`id`),
+  KEY `bundleidentifier` (`bundleidentifier`(191))
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
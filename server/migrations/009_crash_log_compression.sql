@@ -0,0 +1,13 @@
+-- Stores the crash logs compressed in a `mediumblob`
+--
+-- The `text` column cut off logs at 64KB. Existing logs stay uncompressed with
+-- `logcodec` 0, run cli/compress_logs.php afterwards to compress them in the
+-- background. Changing the column copies the `crash` table, so this takes a
+-- while on a big installation.
+--
+-- Apply with: mysql -u <user> -p <database> < 009_crash_log_compression.sql
+
+ALTER TABLE `crash`
+  MODIFY `log` mediumblob NOT NULL,
+  ADD `logcodec` tinyint(3) unsigned NOT NULL default '0' AFTER `log`,
+  ADD `logsize` int(10) unsigned NOT NULL default '0' AFTER `logcodec`;
@@ -0,0 +1,32 @@
+-- Moves the crash log and description of each crash into the `crash_body` table
+--
+-- The crash lists of the admin UI read only the small `crash` rows afterwards,
+-- the bodies are joined when a single crash is shown, downloaded, regrouped or
+-- symbolicated. The keys of `crash` are extended, so these lists are read from
+-- the index in their order. Copying the bodies and rebuilding `crash` takes a
+-- while on a big installation, stop crash_v300.php while this runs.
+--
+-- Apply with: mysql -u <user> -p <database> < 010_crash_body.sql
+
+CREATE TABLE IF NOT EXISTS `crash_body` (
+  `crashid` bigint(20) unsigned NOT NULL,
+  `description` mediumtext collate utf8_unicode_ci,
+  `log` mediumblob NOT NULL,
+  `logcodec` tinyint(3) unsigned NOT NULL default '0',
+  `logsize` int(10) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`crashid`),
+  CONSTRAINT `FK_BODY_CRASHID` FOREIGN KEY (`crashid`) REFERENCES `crash` (`id`) ON DELETE CASCADE
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
+
+INSERT INTO `crash_body` (`crashid`, `description`, `log`, `logcodec`, `logsize`)
+  SELECT `id`, `description`, `log`, `logcodec`, `logsize` FROM `crash`;
+
+ALTER TABLE `crash`
+  DROP `description`,
+  DROP `log`,
+  DROP `logcodec`,
+  DROP `logsize`,
+  DROP KEY `groupid`,
+  ADD KEY `groupid` (`groupid`, `systemversion`, `timestamp`),
+  DROP KEY `bundleidentifier`,
+  ADD KEY `bundleidentifier` (`bundleidentifier`, `version`, `timestamp`);
@@ -0,0 +1,17 @@
+-- Adds composite keys matching the queries of the admin UI and of regrouping
+--
+-- `crash` is filtered by app, version and group, its lists are ordered by system
+-- version and time and its charts count the crashes per system version and
+-- platform. `crash_groups` are listed per app and version ordered by amount.
+-- Check the query plans afterwards with bench/explain_queries.php.
+--
+-- Apply with: mysql -u <user> -p <database> < 011_query_indexes.sql
+
+ALTER TABLE `crash`
+  ADD KEY `versiongroup` (`bundleidentifier`, `version`, `groupid`, `systemversion`, `timestamp`),
+  ADD KEY `systemversion` (`bundleidentifier`, `version`, `systemversion`),
+  ADD KEY `platform` (`bundleidentifier`, `version`, `platform`);
+
+ALTER TABLE `crash_groups`
+  DROP KEY `bundleIdentifier`,
+  ADD KEY `amount` (`bundleidentifier`, `affected`, `amount`);
@@ -0,0 +1,68 @@
+-- Partitions the crash bodies and stack frames by month and adds the retention
+-- of each app and the background deletion of versions
+--
+-- Partitioned tables can't have foreign keys, so the bodies and frames of deleted
+-- crashes are deleted by the code from now on. Both tables are copied into new
+-- partitioned tables, which takes a while on a big installation, stop
+-- crash_v300.php while this runs. All existing rows go to the partition `pmax`,
+-- run cli/expire_crashes.php once afterwards, still before accepting crashes
+-- again: it moves them into their monthly partitions.
+--
+-- Apply with: mysql -u <user> -p <database> < 012_crash_retention.sql
+
+ALTER TABLE `apps`
+  ADD `retention` smallint(5) unsigned default NULL;
+
+CREATE TABLE IF NOT EXISTS `delete_jobs` (
+  `id` bigint(20) unsigned NOT NULL auto_increment,
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci default NULL,
+  `affected` varchar(20) collate utf8_unicode_ci default NULL,
+  `lastid` bigint(20) unsigned NOT NULL default '0',
+  `deleted` bigint(20) NOT NULL default '0',
+  `started` bigint(20) NOT NULL default '0',
+  `updated` bigint(20) NOT NULL default '0',
+  `done` tinyint(4) NOT NULL default '0',
+  PRIMARY KEY  (`id`),
+  KEY `done` (`done`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
+
+CREATE TABLE `crash_body_partitioned` (
+  `crashid` bigint(20) unsigned NOT NULL,
+  `month` mediumint(8) unsigned NOT NULL default '0',
+  `description` mediumtext collate utf8_unicode_ci,
+  `log` mediumblob NOT NULL,
+  `logcodec` tinyint(3) unsigned NOT NULL default '0',
+  `logsize` int(10) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`crashid`, `month`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci
+PARTITION BY RANGE (`month`) (PARTITION pmax VALUES LESS THAN MAXVALUE);
+
+INSERT INTO `crash_body_partitioned` (`crashid`, `month`, `description`, `log`, `logcodec`, `logsize`)
+  SELECT `crash_body`.`crashid`, DATE_FORMAT(`crash`.`timestamp`, '%Y%m'), `crash_body`.`description`, `crash_body`.`log`, `crash_body`.`logcodec`, `crash_body`.`logsize`
+  FROM `crash_body` JOIN `crash` ON `crash`.`id` = `crash_body`.`crashid`;
+
+CREATE TABLE `crash_frames_partitioned` (
+  `crashid` bigint(20) unsigned NOT NULL,
+  `month` mediumint(8) unsigned NOT NULL default '0',
+  `thread` smallint(6) NOT NULL default '0',
+  `crashed` tinyint(3) unsigned NOT NULL default '0',
+  `frame` smallint(5) unsigned NOT NULL default '0',
+  `image` varchar(64) collate utf8_unicode_ci NOT NULL default '',
+  `imageuuid` binary(16) default NULL,
+  `offset` bigint(20) unsigned NOT NULL default '0',
+  `symbol` varchar(250) collate utf8_unicode_ci default NULL,
+  PRIMARY KEY  (`crashid`, `thread`, `frame`, `month`),
+  KEY `symbol` (`symbol`(191)),
+  KEY `image` (`imageuuid`, `offset`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci
+PARTITION BY RANGE (`month`) (PARTITION pmax VALUES LESS THAN MAXVALUE);
+
+INSERT INTO `crash_frames_partitioned` (`crashid`, `month`, `thread`, `crashed`, `frame`, `image`, `imageuuid`, `offset`, `symbol`)
+  SELECT `crash_frames`.`crashid`, DATE_FORMAT(`crash`.`timestamp`, '%Y%m'), `crash_frames`.`thread`, `crash_frames`.`crashed`, `crash_frames`.`frame`,
+    `crash_frames`.`image`, `crash_frames`.`imageuuid`, `crash_frames`.`offset`, `crash_frames`.`symbol`
+  FROM `crash_frames` JOIN `crash` ON `crash`.`id` = `crash_frames`.`crashid`;
+
+RENAME TABLE `crash_body` TO `crash_body_old`, `crash_body_partitioned` TO `crash_body`,
+  `crash_frames` TO `crash_frames_old`, `crash_frames_partitioned` TO `crash_frames`;
+
+DROP TABLE `crash_body_old`, `crash_frames_old`;
@@ -0,0 +1,25 @@
+-- Adds the hourly rollup of the crashes the charts and counts of the admin UI read
+--
+-- New crashes are counted at ingest. The existing crashes are counted once here,
+-- which reads the whole crash table, so run it while no crashes are accepted.
+-- cli/rebuild_rollups.php counts them again at any time.
+--
+-- Apply with: mysql -u <user> -p <database> < 013_crash_rollup.sql
+
+CREATE TABLE IF NOT EXISTS `crash_rollup` (
+  `bundleidentifier` varchar(250) collate utf8_unicode_ci NOT NULL default '',
+  `version` varchar(15) collate utf8_unicode_ci NOT NULL default '',
+  `groupid` bigint(20) unsigned NOT NULL default '0',
+  `systemversion` varchar(25) collate utf8_unicode_ci NOT NULL default '',
+  `platform` varchar(25) collate utf8_unicode_ci NOT NULL default '',
+  `hour` datetime NOT NULL,
+  `amount` int(10) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`bundleidentifier`, `version`, `groupid`, `systemversion`, `platform`, `hour`),
+  KEY `groupid` (`groupid`, `hour`)
+) ENGINE=InnoDB  DEFAULT CHARSET=utf8 COLLATE=utf8_unicode_ci;
+
+INSERT INTO `crash_rollup` (`bundleidentifier`, `version`, `groupid`, `systemversion`, `platform`, `hour`, `amount`)
+  SELECT IFNULL(`bundleidentifier`, ''), IFNULL(`version`, ''), IFNULL(`groupid`, 0), IFNULL(`systemversion`, ''), IFNULL(`platform`, ''),
+    DATE_FORMAT(`timestamp`, '%Y-%m-%d %H:00:00'), COUNT(*)
+  FROM `crash`
+  GROUP BY 1, 2, 3, 4, 5, 6;
@@ -0,0 +1,12 @@
+-- Adds keys ending in the crash id for the queries that read crashes in chunks
+--
+-- Regrouping reads the crashes of a version, or of one of its groups, in chunks
+-- ordered by id. The keys of 011_query_indexes.sql continue with system version
+-- and time after the group, so every chunk had to sort all remaining crashes.
+-- Check the query plans afterwards with bench/explain_queries.php.
+--
+-- Apply with: mysql -u <user> -p <database> < 014_crash_chunk_keys.sql
+
+ALTER TABLE `crash`
+  ADD KEY `versionchunk` (`bundleidentifier`, `version`, `id`),
+  ADD KEY `groupchunk` (`bundleidentifier`, `version`, `groupid`, `id`);
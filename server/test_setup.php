@@ -39,6 +39,10 @@ echo "XMLReader: ";
 if (!class_exists('XMLReader', false)) echo "FAILED"; else echo "passed";
 echo "<br>";
 
+echo "Compressed submissions: ";
+if (!function_exists('inflate_init')) echo "FAILED (zlib with inflate_init is required for gzip and deflate encoded submissions)"; else echo "passed";
+echo "<br>";
+
 echo "Prowl: ";
 $curl_info = curl_version();	// Checks for cURL function and SSL version. Thanks Adrian Rollett!
 if(!function_exists('curl_exec') || empty($curl_info['ssl_version']))
@@ -61,15 +65,19 @@ else
 }
 echo "<br>";
 
+echo "MySQLi: ";
+if (!function_exists('mysqli_stmt_get_result')) echo "FAILED (mysqli with the mysqlnd driver is required)"; else echo "passed";
+echo "<br>";
+
 echo "Database access: ";
-$link = mysql_connect($server, $loginsql, $passsql);
+$link = @mysqli_connect($server, $loginsql, $passsql);
 if ($link === false) echo "FAILED";
 else {
-    if (mysql_select_db($base) === false) echo "FAILED";
+    if (mysqli_select_db($link, $base) === false) echo "FAILED";
     else
         echo "passed";
         
-    mysql_close($link);
+    mysqli_close($link);
 }
 echo "<br>";
 	